@@ -0,0 +1,61 @@
+#ifndef BELADY_H
+#define BELADY_H
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// Belady's MIN over one fully associative set. Each resident key carries the
+// trace index of its next use; a max-heap over those picks the victim, with
+// entries left behind by later hits skipped when they surface. The heap is
+// rebuilt from the resident keys once stale entries outnumber live ones, so
+// memory stays proportional to the capacity.
+class BeladySet {
+
+private:
+  std::unordered_map<uint64_t, uint64_t> resident;
+  std::priority_queue<std::pair<uint64_t, uint64_t>> heap;
+  size_t capacity;
+  void compact();
+
+public:
+  explicit BeladySet(size_t capacity) : capacity(capacity) {}
+  bool access(uint64_t key, uint64_t next_use);
+};
+
+// Offline bound for the online replacement policies. References are
+// recorded as issued (virtual addresses when VM is on) along with the
+// physical address the caches saw, or loaded from a trace file. A backward
+// pass builds next-use indices at page or line granularity, then the trace
+// is replayed under MIN and under each online policy. Cache levels are
+// replayed one at a time on the full physical stream, as in the mrc
+// shadows, since the stream a lower level sees depends on the policy above.
+class BeladyAnalyzer {
+
+private:
+  static constexpr uint64_t NEVER = static_cast<uint64_t>(-1);
+  bool enabled = false;
+  std::vector<uint64_t> references;
+  std::vector<uint64_t> physical;
+  static void next_uses(const std::vector<uint64_t> &trace, size_t unit,
+                        std::vector<uint64_t> &next);
+  static void print_gap(const char *policy, size_t misses, size_t optimal,
+                        const char *unit);
+
+public:
+  void start();
+  void stop() { enabled = false; }
+  bool is_enabled() const { return enabled; }
+  void record(uint64_t address, uint64_t physical_address);
+  bool load_file(const std::string &path);
+  size_t size() const { return references.size(); }
+  void report_frames(size_t page_size, size_t frames) const;
+  void report_cache(int level, size_t size, size_t block_size,
+                    size_t ways) const;
+};
+
+#endif
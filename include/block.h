@@ -1,15 +1,37 @@
 #ifndef BLOCK_H
 #define BLOCK_H
 #include <cstddef>  
+#include <cstdint>
 
+// Payload sizes are multiples of 8, so the low bits of size_flags carry the
+// block's own free bit and whether the physically previous block is free.
+const uint32_t BLOCK_FREE = 1;
+const uint32_t BLOCK_PREV_FREE = 2;
+const uint32_t BLOCK_FLAG_MASK = 7;
+const size_t MIN_BLOCK_PAYLOAD = 8;
 
 struct BlockHeader {
-    size_t size;         
-    size_t padding;      
-    bool is_free;
-    BlockHeader* next;
-    BlockHeader* prev;
-    int id;
+    uint32_t size_flags;
+    uint32_t id : 29;
+    uint32_t padding : 3;
+
+    size_t size() const { return size_flags & ~BLOCK_FLAG_MASK; }
+    bool is_free() const { return size_flags & BLOCK_FREE; }
+    bool prev_free() const { return size_flags & BLOCK_PREV_FREE; }
+
+    void set_size(size_t s) {
+        size_flags = static_cast<uint32_t>(s) | (size_flags & BLOCK_FLAG_MASK);
+    }
+
+    void set_flag(uint32_t flag, bool on) {
+        size_flags = on ? (size_flags | flag) : (size_flags & ~flag);
+    }
+};
+
+// Boundary tag in the last bytes of a free block's payload, read by the next
+// block to find its free predecessor without a prev link.
+struct BlockFooter {
+    uint32_t size;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,32 +1,59 @@
 #ifndef BUDDY_ALLOCATOR_H
 #define BUDDY_ALLOCATOR_H
-#include "block.h"
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 
 
+// Buddy state lives outside the managed memory: one free bitmap per order
+// (bit i set means the block at offset i << order is free), a mask of orders
+// that have any free block, and the order of each allocated block indexed by
+// its offset in minimum-block units. Usage counters are kept per order as
+// blocks are handed out and returned.
 class BuddyAllocator {
 
 private:
-  static const int MIN_BLOCK_SIZE = 32;
-  static const int MAX_LEVELS = 32;
-  BlockHeader *free_lists[MAX_LEVELS];
+  static const int MIN_BLOCK_SIZE = 16;
+  static const int MAX_LEVELS = 64;
+  std::vector<uint64_t> free_maps[MAX_LEVELS];
+  size_t free_counts[MAX_LEVELS];
+  size_t first_word_hint[MAX_LEVELS];
+  size_t alloc_counts[MAX_LEVELS];
+  uint64_t order_mask;
+  size_t allocated_bytes;
+  size_t requested_bytes;
+  std::unordered_map<size_t, size_t> requested_sizes;
+  std::vector<uint8_t> alloc_orders;
   char *memory_start;  
   size_t total_size;
   int min_order;  
   int max_order;  
   int get_order(size_t size);
   size_t get_size_from_order(int order);
-  BlockHeader *get_block(int order);
+  bool test_free(int order, size_t offset);
+  void mark_free(int order, size_t offset);
+  void clear_free(int order, size_t offset);
+  size_t take_first_free(int order);
+  size_t get_block(int order);
+  void record_alloc(size_t offset, int order, size_t size);
+  void record_free(size_t offset, int order);
 
 public:
+  static const size_t NPOS = static_cast<size_t>(-1);
   BuddyAllocator();
   void init(char *memory, size_t size);
   void *malloc(size_t size);
   void free(void *ptr);
+  bool owns(void *ptr);
+  size_t usable_size(void *ptr);
+  bool resize_in_place(void *ptr, size_t size);
+  void collect_stats(size_t &used, size_t &free_bytes, size_t &internal_frag,
+                     size_t &largest_free);
+  void print_order_stats();
   void debug_lists();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,57 +1,217 @@
 #ifndef CACHE_H
 #define CACHE_H
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <iostream>
+#include <memory>
+#include <unordered_set>
 #include <vector>
+#include "prefetcher.h"
 
 
-enum class CacheReplacementPolicy { FIFO, LRU, LFU };
+enum class CacheReplacementPolicy { FIFO, LRU, LFU, PLRU, SRRIP, BRRIP, DRRIP };
 
-struct CacheBlock {
-  bool valid = false;
-  bool dirty = false;
-  size_t tag = 0;
-  size_t last_access_time = 0;
-  size_t access_count = 0;
-};
+enum class InclusionPolicy { NINE, INCLUSIVE, EXCLUSIVE };
+
+enum class CacheAccess { DEMAND, LOOKUP, PREFETCH, VICTIM_FILL };
 
-struct CacheSet {
-  std::vector<CacheBlock> blocks;
-  int fifo_next_victim = 0;
+struct CacheVictim {
+  size_t address;
+  bool dirty;
 };
 
+// Lines are stored structure-of-arrays: all tags of a set sit next to each
+// other in one flat array so a lookup is a single vector compare, validity
+// and dirtiness are one bitmask per set, and replacement metadata lives in
+// its own arrays that are only touched on hits and misses. Tree-PLRU and the
+// RRIP family use bit-packed per-set state (ways - 1 bits and 2 bits per
+// line respectively).
 class CacheLevel {
 
-private:
+protected:
+  static const size_t RRPV_WORDS = 2;
+  static const uint64_t RRPV_MAX = 3;
+  static const size_t BRRIP_PERIOD = 32;
+  static const size_t DUEL_PERIOD = 32;
+  static const uint32_t PSEL_MAX = 1023;
   int level_id;
   size_t size;
   size_t block_size;
   size_t associativity;
   size_t num_sets;
-  std::vector<CacheSet> sets;
+  std::vector<uint64_t> tags;
+  std::vector<uint64_t> valid_bits;
+  std::vector<uint64_t> dirty_bits;
+  std::vector<uint64_t> prefetched_bits;
+  std::vector<uint64_t> last_access;
+  std::vector<uint64_t> ready_at;
+  std::vector<uint32_t> access_counts;
+  std::vector<uint32_t> fifo_next;
+  std::vector<uint64_t> plru_bits;
+  std::vector<uint64_t> rrpv;
+  uint32_t psel = PSEL_MAX / 2;
+  size_t brrip_fills = 0;
   size_t hits = 0;
   size_t misses = 0;
   CacheReplacementPolicy policy = CacheReplacementPolicy::FIFO;
   size_t timer = 0;
+  std::unique_ptr<Prefetcher> prefetcher;
+  std::vector<size_t> prefetch_queue;
+  std::vector<size_t> prefetch_fills;
+  std::unordered_set<size_t> displaced_by_prefetch;
+  std::deque<size_t> displaced_order;
+  size_t prefetches_issued = 0;
+  size_t prefetches_useful = 0;
+  size_t prefetches_unused = 0;
+  size_t pollution_misses = 0;
+  bool track_victims = false;
+  std::vector<CacheVictim> victims;
+  bool write_through = false;
+  bool write_allocate = true;
+  size_t write_backs = 0;
+  void note_prefetch_victim(size_t line);
+  void run_prefetcher(size_t line, bool hit, bool prefetched_hit);
+  int plru_victim(size_t set, size_t ways) const;
+  void plru_touch(size_t set, size_t way, size_t ways);
+  int rrip_victim(size_t set, size_t ways);
+  void set_rrpv(size_t set, size_t way, uint64_t value);
+  static uint64_t rrpv_lanes(size_t word, size_t ways);
+  uint64_t brrip_insertion();
+  bool drrip_uses_brrip(size_t set) const;
+  void drrip_leader_miss(size_t set);
+  template <CacheReplacementPolicy P>
+  int choose_victim(size_t set, size_t ways);
+  template <CacheReplacementPolicy P>
+  void on_hit(size_t set, size_t way, size_t ways);
+  template <CacheReplacementPolicy P>
+  void on_fill(size_t set, size_t way, size_t ways);
+  template <CacheReplacementPolicy P, typename Geometry>
+  bool access_with(size_t address, bool is_write, CacheAccess kind,
+                   const Geometry &geometry);
+  template <typename Geometry>
+  bool dispatch(size_t address, bool is_write, CacheAccess kind,
+                const Geometry &geometry);
 
 public:
+  static const size_t MAX_ASSOCIATIVITY = 64;
   CacheLevel(int id, size_t size, size_t block_size, size_t associativity);
-  bool access(size_t address, bool is_write);
+  virtual ~CacheLevel() = default;
+  virtual bool perform(size_t address, bool is_write, CacheAccess kind);
+  bool access(size_t address, bool is_write) {
+    return perform(address, is_write, CacheAccess::DEMAND);
+  }
+  bool lookup(size_t address, bool is_write) {
+    return perform(address, is_write, CacheAccess::LOOKUP);
+  }
+  bool prefetch(size_t address) {
+    return !perform(address, false, CacheAccess::PREFETCH);
+  }
+  bool install(size_t address, bool dirty) {
+    return perform(address, dirty, CacheAccess::VICTIM_FILL);
+  }
   void set_policy(CacheReplacementPolicy p);
+  void set_prefetcher(PrefetcherType type, int degree);
   void reset_stats();
+  bool contains(size_t address) const;
+  bool invalidate(size_t address, bool *was_dirty = nullptr);
+  std::vector<size_t> resident_lines() const;
+  void set_victim_tracking(bool enabled);
+  std::vector<CacheVictim> &evicted() { return victims; }
+  std::vector<size_t> &prefetched() { return prefetch_fills; }
+  size_t ready_time(size_t address) const;
+  void set_ready_time(size_t address, size_t cycle);
+  void set_write_policy(bool write_through, bool write_allocate);
+  bool is_write_through() const { return write_through; }
+  bool allocates_on_write() const { return write_allocate; }
+  bool mark_dirty(size_t address);
+  size_t get_block_size() const { return block_size; }
+  size_t get_associativity() const { return associativity; }
+  size_t get_capacity() const { return num_sets * associativity * block_size; }
+  size_t get_write_backs() const { return write_backs; }
   size_t get_hits() const { return hits; }
   size_t get_misses() const { return misses; }
   double get_hit_rate() const;
   void print_stats() const;
 };
 
+// Cache level whose geometry is fixed at compile time: all three parameters
+// are powers of two, so set index and tag are a shift and a mask, the way
+// loops have a constant trip count, and the replacement policy is a template
+// argument of the access path. Instantiations live in cache.cpp and are
+// picked by create_cache_level when a requested geometry matches one.
+template <size_t BlockSize, size_t NumSets, size_t Ways>
+class StaticCacheLevel : public CacheLevel {
+  static_assert((BlockSize & (BlockSize - 1)) == 0, "block size");
+  static_assert((NumSets & (NumSets - 1)) == 0, "set count");
+  static_assert(Ways > 0 && Ways <= MAX_ASSOCIATIVITY, "associativity");
+
+public:
+  explicit StaticCacheLevel(int id);
+  bool perform(size_t address, bool is_write, CacheAccess kind) override;
+};
+
+CacheLevel *create_cache_level(int id, size_t size, size_t block_size,
+                               size_t associativity);
+// With specialization off every level is a generic CacheLevel, which is
+// what the instantiations are checked against.
+void set_cache_specialization(bool enabled);
+
+// Requests walk down the levels and each level they reach adds its hit
+// latency; an L3 miss adds the DRAM latency. Fills travel down as reads,
+// prefetch fills included, though those run in the background: the core
+// only waits for one when a demand access hits the line before it arrives.
+// Writes that a level does not keep (write-through, or a miss without
+// write-allocate) continue to the next level; out of L1 they go through a
+// coalescing write buffer that drains in the background and only stalls the
+// core when it is full. Dirty victims are written back into the nearest
+// lower level holding the line, or to DRAM, off the critical path.
+//
+// Non-inclusive non-exclusive (NINE) fills every level a miss passes
+// through and nothing more. Inclusive additionally back-invalidates the
+// levels above whenever a line leaves a lower level. Exclusive looks the
+// lower levels up without allocating, moves a hit line up into L1 and fills
+// each level only with the victims of the level above. An optional fully
+// associative victim cache holds L1 victims and swaps a line back into L1
+// on a hit.
 class CacheHierarchy {
 
 private:
+  struct BufferedWrite {
+    size_t line;
+    size_t done;
+  };
   CacheLevel *l1;
   CacheLevel *l2;
   CacheLevel *l3;
+  CacheLevel *victim_cache;
+  InclusionPolicy inclusion = InclusionPolicy::NINE;
+  size_t latencies[3] = {4, 12, 40};
+  size_t dram_latency = 200;
+  size_t accesses = 0;
+  size_t total_cycles = 0;
+  size_t dram_reads = 0;
+  size_t dram_writes = 0;
+  std::deque<BufferedWrite> write_buffer;
+  size_t write_buffer_capacity = 8;
+  size_t buffered_writes = 0;
+  size_t coalesced_writes = 0;
+  size_t forwarded_reads = 0;
+  size_t write_buffer_stalls = 0;
+  size_t victim_latency = 1;
+  size_t victim_hits = 0;
+  size_t victim_misses = 0;
+  size_t back_invalidations = 0;
+  CacheLevel *level(int i) const;
+  size_t access_level(int i, size_t address, bool is_write, size_t now);
+  void fetch_prefetches(int i, size_t now);
+  size_t buffer_write(size_t address);
+  bool retire_writes(size_t line);
+  void handle_victims(int i);
+  void evict_line(int i, const CacheVictim &victim);
+  void write_back(int i, size_t address);
+  bool back_invalidate(int i, size_t address);
+  void print_inclusion_stats() const;
 
 public:
   CacheHierarchy();
@@ -60,7 +220,14 @@ public:
             size_t l2_size, size_t l2_block_size, size_t l2_assoc,
             size_t l3_size, size_t l3_block_size, size_t l3_assoc);
   void set_policy(CacheReplacementPolicy p);
+  void set_prefetcher(int level, PrefetcherType type, int degree);
+  void set_latency(int level, size_t cycles);
+  void set_write_policy(int level, bool write_through, bool write_allocate);
+  void set_write_buffer(size_t entries);
+  void set_inclusion(InclusionPolicy p);
+  void set_victim_cache(size_t entries);
   void access(size_t address, char type);
+  const CacheLevel *get_level(int i) const { return level(i); }
   void print_stats();
 };
 
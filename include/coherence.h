@@ -0,0 +1,91 @@
+#ifndef COHERENCE_H
+#define COHERENCE_H
+#include "cache.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+enum class CoherenceProtocol { MESI, MOESI };
+
+enum class LineState : uint8_t { INVALID, SHARED, EXCLUSIVE, OWNED, MODIFIED };
+
+// N cores, each with a private L1/L2 pair, kept coherent by snooping over a
+// shared bus in front of an inclusive shared L3. A core's private caches
+// form one coherence unit whose MESI/MOESI state per line lives next to
+// them. Hits that need no bus transaction only take the core's own lock, so
+// per-core traces run in parallel threads and serialize on the bus only for
+// misses, upgrades and L3 traffic. The bus lock serializes snoops: a bus
+// transaction holds it and then takes every core lock in index order.
+//
+// Coherence misses are split into true and false sharing: after a core
+// loses a line to another core's write, the words written by the other
+// cores are collected until it misses on the line again; the miss is false
+// sharing if the word it wants is not among them.
+class MultiCoreSystem {
+
+private:
+  static const int MAX_CORES = 64;
+  static const size_t WORD_SIZE = 4;
+  struct PrivateLine {
+    LineState state;
+    uint64_t written;
+  };
+  struct Core {
+    std::unique_ptr<CacheLevel> l1;
+    std::unique_ptr<CacheLevel> l2;
+    std::unordered_map<uint64_t, PrivateLine> lines;
+    std::vector<std::pair<uint64_t, uint64_t>> evicted_writes;
+    std::mutex lock;
+    size_t reads = 0;
+    size_t writes = 0;
+    size_t write_backs = 0;
+    size_t invalidations_received = 0;
+    size_t true_sharing_misses = 0;
+    size_t false_sharing_misses = 0;
+  };
+  struct SharingRecord {
+    uint64_t pending = 0;
+    std::vector<uint64_t> words;
+  };
+  CoherenceProtocol protocol = CoherenceProtocol::MESI;
+  size_t block_size = 64;
+  std::vector<std::unique_ptr<Core>> cores;
+  std::unique_ptr<CacheLevel> l3;
+  std::mutex bus;
+  std::unordered_map<uint64_t, SharingRecord> sharing;
+  std::map<uint64_t, size_t> false_sharing_lines;
+  size_t bus_reads = 0;
+  size_t bus_read_exclusives = 0;
+  size_t upgrades = 0;
+  size_t invalidations = 0;
+  size_t cache_to_cache = 0;
+  size_t back_invalidations = 0;
+  size_t memory_write_backs = 0;
+  uint64_t word_bit(size_t address) const;
+  bool private_hit(Core &core, uint64_t line, size_t address, bool is_write);
+  void touch_private(Core &core, size_t address, bool is_write);
+  void leave_private(Core &core, uint64_t line);
+  void drain_evictions(Core &core);
+  void fold_writes(uint64_t line, uint64_t written);
+  void bus_access(int id, uint64_t line, size_t address, bool is_write);
+  void back_invalidate(uint64_t line);
+
+public:
+  void init(int num_cores, CoherenceProtocol protocol, size_t l1_size,
+            size_t l2_size, size_t l3_size, size_t block_size);
+  bool is_enabled() const { return !cores.empty(); }
+  int core_count() const { return static_cast<int>(cores.size()); }
+  void set_policy(CacheReplacementPolicy p);
+  void access(int core, size_t address, bool is_write);
+  bool run_traces(const std::vector<std::string> &paths, bool parallel);
+  void print_stats();
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef CONCURRENT_ALLOCATOR_H
+#define CONCURRENT_ALLOCATOR_H
+#include "tlsf_allocator.h"
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+// Thread-safe allocator made of N TLSF arenas that partition one buffer.
+// Each thread owns a ThreadCache bound to a home arena; small objects are
+// served from per-class stacks refilled and flushed in batches, and frees of
+// blocks owned by another arena go onto that arena's lock-free remote-free
+// stack, which the owner drains the next time it takes its lock.
+class ConcurrentAllocator {
+
+public:
+  static const int NUM_CLASSES = 5;
+  static const size_t BATCH_SIZE = 16;
+  static const size_t CACHE_LIMIT = 64;
+
+  struct ThreadCache {
+    int home_arena = -1;
+    std::vector<void *> bins[NUM_CLASSES];
+    size_t hits = 0;
+    size_t refills = 0;
+    size_t flushes = 0;
+  };
+
+private:
+  static const size_t CLASS_SIZES[NUM_CLASSES];
+  struct RemoteNode {
+    RemoteNode *next;
+  };
+  struct alignas(64) Arena {
+    TLSFAllocator heap;
+    std::mutex lock;
+    std::atomic<RemoteNode *> remote_frees{nullptr};
+    std::atomic<size_t> lock_acquisitions{0};
+    std::atomic<size_t> contended_locks{0};
+    std::atomic<size_t> remote_free_count{0};
+  };
+  std::vector<std::unique_ptr<Arena>> arenas;
+  char *memory_start = nullptr;
+  size_t arena_size = 0;
+  bool verbose = true;
+  std::atomic<int> next_home{0};
+  std::atomic<size_t> cache_hits{0};
+  std::atomic<size_t> refills{0};
+  std::atomic<size_t> flushes{0};
+  int get_class(size_t size) const;
+  int arena_of(void *ptr) const;
+  void lock_arena(Arena &arena);
+  void drain_remote_frees(Arena &arena);
+  void bind(ThreadCache &cache);
+  void push_remote(Arena &arena, void *ptr);
+
+public:
+  void init(char *memory, size_t size, int num_arenas);
+  int get_num_arenas() const { return static_cast<int>(arenas.size()); }
+  void set_verbose(bool v) { verbose = v; }
+  void *malloc(ThreadCache &cache, size_t size);
+  void free(ThreadCache &cache, void *ptr);
+  void flush(ThreadCache &cache);
+  bool owns(ThreadCache &cache, void *ptr);
+  void collect_stats(size_t &used, size_t &free_bytes, size_t &internal_frag,
+                     size_t &largest_free);
+  void print_stats(ThreadCache &cache);
+  void debug_lists();
+  void run_benchmark(int max_threads, size_t ops_per_thread);
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef FREE_BLOCK_INDEX_H
+#define FREE_BLOCK_INDEX_H
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <set>
+#include <utility>
+
+
+// Index of free blocks keyed by header offset. Blocks are kept in segregated
+// power-of-two size classes (address ordered inside each class) for first
+// fit, plus a (size, offset) ordered set for best and worst fit. The bins
+// double as the free-size histogram.
+class FreeBlockIndex {
+
+private:
+  static const int NUM_BINS = 64;
+  std::map<size_t, size_t> bins[NUM_BINS];
+  std::set<std::pair<size_t, size_t>> by_size;
+  size_t free_bytes = 0;
+  int get_bin(size_t size) const;
+
+public:
+  static const size_t NPOS = static_cast<size_t>(-1);
+  void clear();
+  void insert(size_t offset, size_t size);
+  void erase(size_t offset, size_t size);
+  size_t find_first_fit(size_t size) const;
+  size_t find_best_fit(size_t size) const;
+  size_t find_worst_fit(size_t size) const;
+  size_t count() const { return by_size.size(); }
+  size_t total_bytes() const { return free_bytes; }
+  size_t largest() const;
+  void print_histogram() const;
+};
+
+#endif
@@ -2,14 +2,32 @@
 #define MEMORY_MANAGER_H
 #include "block.h"
 #include <cstddef>  
+#include <functional>
 #include <iostream>
+#include <queue>
+#include <unordered_map>
 #include <vector>
 #include "buddy_allocator.h"
 #include "cache.h"
+#include "coherence.h"
+#include "concurrent_allocator.h"
+#include "free_block_index.h"
+#include "slab_allocator.h"
+#include "belady.h"
+#include "stack_distance.h"
+#include "tlsf_allocator.h"
 #include "virtual_memory.h"
 
 
-enum class AllocationStrategy { FIRST_FIT, BEST_FIT, WORST_FIT, BUDDY };
+enum class AllocationStrategy {
+  FIRST_FIT,
+  BEST_FIT,
+  WORST_FIT,
+  BUDDY,
+  TLSF,
+  SLAB,
+  CONCURRENT
+};
 
 class MemoryManager {
 
@@ -20,16 +38,57 @@ private:
   int next_alloc_id;  
   size_t align(size_t n);  
   int get_next_available_id();
+  void release_id(int id);
+  std::priority_queue<int, std::vector<int>, std::greater<int>> released_ids;
+  std::unordered_map<size_t, BlockHeader *> blocks_by_offset;
+  std::unordered_map<int, BlockHeader *> blocks_by_id;
   size_t total_alloc_requests = 0;
   size_t successful_allocs = 0;
   AllocationStrategy current_strategy = AllocationStrategy::FIRST_FIT;
   CacheHierarchy cache_system;
+  size_t cache_geometry[3][3] = {{64, 8, 1}, {256, 8, 2}, {1024, 64, 8}};
+  StackDistanceAnalyzer mrc_analyzer;
+  BeladyAnalyzer opt_analyzer;
+  MultiCoreSystem multicore;
   BuddyAllocator buddy_system;
+  TLSFAllocator tlsf_system;
+  SlabAllocator slab_system;
+  ConcurrentAllocator concurrent_system;
+  ConcurrentAllocator::ThreadCache main_thread_cache;
+  int concurrent_arenas = 4;
+  bool auto_compact = false;
+  size_t compactions = 0;
+  size_t compaction_bytes_moved = 0;
+  double compaction_time_us = 0.0;
+  size_t reallocs_in_place = 0;
+  size_t used_bytes = 0;
+  size_t internal_frag_bytes = 0;
+  // Bytes compaction folded into a used block, by ID, because they were too
+  // few to form a free block. They count as internal fragmentation.
+  std::unordered_map<int, size_t> compaction_slack;
+  size_t reallocs_moved = 0;
+  FreeBlockIndex free_index;
   VirtualMemoryManager vm_system;
   bool use_virtual_memory = false;
   BlockHeader *find_first_fit(size_t size);
   BlockHeader *find_best_fit(size_t size);
   BlockHeader *find_worst_fit(size_t size);
+  size_t get_block_offset(BlockHeader *block);
+  void index_free_block(BlockHeader *block);
+  void unindex_free_block(BlockHeader *block);
+  BlockHeader *find_block(void *ptr);
+  BlockHeader *next_block(BlockHeader *block);
+  BlockHeader *prev_free_block(BlockHeader *block);
+  void mark_block(BlockHeader *block, bool is_free);
+  BlockHeader *allocate_block(size_t aligned_size, AllocationStrategy strategy);
+  void release_block(BlockHeader *block);
+  void split_block(BlockHeader *block, size_t aligned_size);
+  void set_padding(BlockHeader *block, size_t padding);
+  bool grow_in_place(BlockHeader *block, size_t aligned_size);
+  void *buddy_realloc(void *ptr, size_t size);
+  void *slab_malloc(size_t size);
+  bool uses_free_list() const;
+  void init_cache();
 
 public:
   void init(size_t size);
@@ -39,14 +98,52 @@ public:
   void free(void *ptr);
   void free_by_id(int id);
   void free_smart(int value);
-  void enable_vm(size_t page_size);
+  void *realloc(void *ptr, size_t size);
+  void *realloc_smart(int value, size_t size);
+  void *calloc(size_t count, size_t size);
+  bool compact();
+  void set_auto_compact(bool enabled) { auto_compact = enabled; }
+  void print_handle(int id);
+  void enable_vm(size_t page_size, int address_bits = 16);
   void access(size_t address, char rw);
   void *get_ptr_from_offset(size_t offset);
   size_t get_offset_from_ptr(void *ptr);
   void set_strategy(AllocationStrategy strategy);
+  void set_arena_count(int arenas);
+  void run_benchmark(int max_threads, size_t ops_per_thread);
+  void set_cache_geometry(int level, size_t size, size_t block_size,
+                          size_t ways);
+  void set_cache_specialization(bool enabled);
   void set_cache_policy(CacheReplacementPolicy policy);
-  void set_vm_policy(ReplacementPolicy policy);
-  void set_vm_latency(int ms);
+  void set_cache_prefetcher(int level, PrefetcherType type, int degree);
+  void set_cache_latency(int level, size_t cycles);
+  void set_cache_write_policy(int level, bool write_through,
+                              bool write_allocate);
+  void set_cache_write_buffer(size_t entries);
+  void set_cache_inclusion(InclusionPolicy policy);
+  void set_cache_victim_entries(size_t entries);
+  void set_vm_policy(ReplacementPolicy policy, size_t window = 0);
+  void set_vm_latency(int read_ms, int write_ms);
+  void set_vm_writeback_batch(size_t pages);
+  void configure_vm_disk(size_t channels, size_t queue_depth);
+  void set_vm_cpu_time(size_t us);
+  void configure_tlb(int level, size_t entries, size_t ways,
+                     CacheReplacementPolicy policy);
+  void set_tlb_walk_latency(size_t cycles);
+  void start_mrc(size_t block_size, double sampling_rate, size_t max_samples);
+  void stop_mrc() { mrc_analyzer.stop(); }
+  void print_mrc() { mrc_analyzer.print_curve(); }
+  void start_opt();
+  void stop_opt() { opt_analyzer.stop(); }
+  void print_opt();
+  void analyze_opt_file(const std::string &path);
+  void analyze_trace_file(const std::string &path, size_t block_size,
+                          double sampling_rate, size_t max_samples);
+  void init_multicore(int cores, CoherenceProtocol protocol, size_t l1_size,
+                      size_t l2_size, size_t l3_size, size_t block_size);
+  bool multicore_access(int core, size_t address, char rw);
+  void run_multicore(const std::vector<std::string> &paths, bool parallel);
+  void print_multicore_stats() { multicore.print_stats(); }
 
   BlockHeader *get_head() { return head; }
 };
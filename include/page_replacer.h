@@ -0,0 +1,170 @@
+#ifndef PAGE_REPLACER_H
+#define PAGE_REPLACER_H
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+
+enum class ReplacementPolicy {
+  FIFO,
+  LRU,
+  CLOCK,
+  ENHANCED_CLOCK,
+  WSCLOCK,
+  ARC,
+  CAR,
+  TWO_Q,
+  LIRS
+};
+
+// Replacement state kept apart from the page table, for policies that need
+// their own recency lists and ghosts of recently evicted pages. Every list
+// is a std::list indexed by a hash map, so each call is amortized O(1).
+// victim() is only called when every frame is in use and always comes
+// before on_fault() for the same incoming page, since some policies adapt
+// on whether that page is a ghost.
+class PageReplacer {
+
+public:
+  virtual ~PageReplacer() = default;
+  virtual const char *name() const = 0;
+  virtual void on_hit(size_t page) = 0;
+  virtual size_t victim(size_t incoming) = 0;
+  virtual void on_fault(size_t page) = 0;
+  virtual void print_stats() const = 0;
+};
+
+// Adaptive Replacement Cache (Megiddo and Modha): T1 holds pages seen once
+// recently and T2 pages seen at least twice, each with a ghost list (B1,
+// B2) of the same length. A ghost hit in B1 grows the target size p of T1,
+// one in B2 shrinks it.
+class ArcReplacer : public PageReplacer {
+
+private:
+  enum List { T1, T2, B1, B2 };
+  struct Node {
+    List list;
+    std::list<size_t>::iterator it;
+  };
+  std::list<size_t> lists[4];
+  std::unordered_map<size_t, Node> nodes;
+  size_t capacity;
+  size_t target = 0;
+  size_t ghost_hits[2] = {0, 0};
+  void move_to(size_t page, List list);
+  void drop_lru(List list);
+  size_t replace(bool incoming_in_b2);
+
+public:
+  explicit ArcReplacer(size_t capacity) : capacity(capacity) {}
+  const char *name() const override { return "ARC"; }
+  void on_hit(size_t page) override;
+  size_t victim(size_t incoming) override;
+  void on_fault(size_t page) override;
+  void print_stats() const override;
+};
+
+// Clock with Adaptive Replacement (Bansal and Modha): ARC's lists with T1
+// and T2 kept as clocks, so a hit only sets a reference bit. T1 pages found
+// referenced by the hand move to T2.
+class CarReplacer : public PageReplacer {
+
+private:
+  enum List { T1, T2, B1, B2 };
+  struct Node {
+    List list;
+    std::list<size_t>::iterator it;
+    bool referenced;
+  };
+  std::list<size_t> lists[4];
+  std::unordered_map<size_t, Node> nodes;
+  size_t capacity;
+  size_t target = 0;
+  size_t ghost_hits[2] = {0, 0};
+  void move_to(size_t page, List list);
+  void drop_lru(List list);
+
+public:
+  explicit CarReplacer(size_t capacity) : capacity(capacity) {}
+  const char *name() const override { return "CAR"; }
+  void on_hit(size_t page) override;
+  size_t victim(size_t incoming) override;
+  void on_fault(size_t page) override;
+  void print_stats() const override;
+};
+
+// Full 2Q (Johnson and Shasha): new pages enter the FIFO A1in (a quarter of
+// the frames); pages evicted from it are remembered in the ghost FIFO A1out
+// (half the frames), and only a fault on an A1out ghost promotes a page to
+// the LRU list Am. One-time scans never reach Am.
+class TwoQueueReplacer : public PageReplacer {
+
+private:
+  enum List { A1IN, A1OUT, AM };
+  struct Node {
+    List list;
+    std::list<size_t>::iterator it;
+  };
+  std::list<size_t> lists[3];
+  std::unordered_map<size_t, Node> nodes;
+  size_t in_limit;
+  size_t out_limit;
+  size_t ghost_hits = 0;
+  void move_to(size_t page, List list);
+
+public:
+  explicit TwoQueueReplacer(size_t capacity);
+  const char *name() const override { return "2Q"; }
+  void on_hit(size_t page) override;
+  size_t victim(size_t incoming) override;
+  void on_fault(size_t page) override;
+  void print_stats() const override;
+};
+
+// Low Inter-reference Recency Set (Jiang and Zhang). Most frames hold LIR
+// pages, those with a short reuse distance; the rest (1%, at least one)
+// hold HIR pages on the queue Q, which supplies every victim. The recency
+// stack S keeps LIR pages, recent HIR pages and ghosts of evicted HIR
+// pages; an HIR page touched again while still in S becomes LIR. Ghosts
+// are capped at one per frame, oldest dropped first.
+class LirsReplacer : public PageReplacer {
+
+private:
+  enum State { LIR, HIR, GHOST };
+  struct Node {
+    State state;
+    bool in_stack = false;
+    bool in_queue = false;
+    std::list<size_t>::iterator stack_it;
+    std::list<size_t>::iterator queue_it;
+    std::list<size_t>::iterator ghost_it;
+  };
+  std::list<size_t> stack;
+  std::list<size_t> queue;
+  std::list<size_t> ghosts;
+  std::unordered_map<size_t, Node> nodes;
+  size_t lir_limit;
+  size_t ghost_limit;
+  size_t lir_count = 0;
+  size_t ghost_hits = 0;
+  void push_stack(size_t page, Node &node);
+  void push_queue(size_t page, Node &node);
+  void demote_bottom();
+  void prune();
+
+public:
+  explicit LirsReplacer(size_t capacity);
+  const char *name() const override { return "LIRS"; }
+  void on_hit(size_t page) override;
+  size_t victim(size_t incoming) override;
+  void on_fault(size_t page) override;
+  void print_stats() const override;
+};
+
+// Returns nullptr for the policies VirtualMemoryManager runs over its own
+// frame table (FIFO, LRU and the clocks).
+std::unique_ptr<PageReplacer> create_page_replacer(ReplacementPolicy policy,
+                                                   size_t capacity);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+struct PageTableEntry {
+  int frame_number = -1;
+  bool valid = false;
+  bool dirty = false;
+  bool swapped = false;
+  bool reference_bit = false;
+  size_t last_access_time = 0;
+  uint64_t ready_time = 0;
+};
+
+// Four-level radix page table over virtual page numbers. The page number
+// bits are split evenly across the levels, with the top level taking what
+// is left; spaces too small to fill four levels use fewer. Directories and
+// leaf tables are only allocated when a page under them is first touched,
+// so a sparse 48-bit space costs a handful of tables. Sizes are reported
+// as if every slot were an 8-byte hardware entry.
+class RadixPageTable {
+
+private:
+  static const int MAX_LEVELS = 4;
+  static const size_t ENTRY_BYTES = 8;
+  struct Node {
+    std::vector<std::unique_ptr<Node>> children;
+    std::vector<PageTableEntry> entries;
+  };
+  std::unique_ptr<Node> root;
+  int levels = 1;
+  int bits_per_level = 0;
+  int page_bits = 0;
+  size_t nodes_per_level[MAX_LEVELS] = {};
+  size_t fanout(int level) const;
+  size_t slot(size_t vpn, int level) const;
+  Node *make_node(int level);
+
+public:
+  void init(int page_number_bits);
+  PageTableEntry *find(size_t vpn, int *depth = nullptr) const;
+  PageTableEntry &get(size_t vpn);
+  int get_levels() const { return levels; }
+  size_t table_bytes() const;
+  size_t dense_bytes() const;
+  void print_stats() const;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PAGING_DISK_H
+#define PAGING_DISK_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+
+// Paging device on a simulated microsecond clock. Requests are served by a
+// fixed number of channels in arrival order; a request that finds every
+// channel busy waits in a bounded queue. The completion times of requests
+// still in flight form the event queue the caller retires against its own
+// clock. Overlap is total service time over the time the device was busy,
+// i.e. the mean number of requests in service while any was.
+class PagingDisk {
+
+private:
+  using MinHeap = std::priority_queue<uint64_t, std::vector<uint64_t>,
+                                      std::greater<uint64_t>>;
+  size_t channels = 1;
+  size_t queue_depth = 0;
+  MinHeap channel_free;
+  MinHeap in_flight;
+  size_t requests = 0;
+  size_t max_in_flight = 0;
+  uint64_t service_time = 0;
+  uint64_t queue_wait = 0;
+  uint64_t busy_time = 0;
+  uint64_t busy_until = 0;
+
+public:
+  void configure(size_t channels, size_t queue_depth);
+  void reset();
+  void retire(uint64_t now);
+  bool full() const { return in_flight.size() >= channels + queue_depth; }
+  uint64_t next_completion() const { return in_flight.top(); }
+  uint64_t submit(uint64_t now, uint64_t service);
+  uint64_t drained_at() const { return busy_until; }
+  size_t get_requests() const { return requests; }
+  void print_stats() const;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+enum class PrefetcherType { NONE, NEXT_LINE, STRIDE, STREAM };
+
+// A prefetcher watches the demand stream of one cache level, in units of
+// that level's lines, and appends the lines it wants brought in.
+class Prefetcher {
+
+public:
+  virtual ~Prefetcher() = default;
+  virtual const char *name() const = 0;
+  virtual void on_access(size_t line, bool hit, bool prefetched_hit,
+                         std::vector<size_t> &lines) = 0;
+};
+
+// Tagged next-line: fetches the following lines on a miss and on the first
+// demand hit to a line that was itself prefetched.
+class NextLinePrefetcher : public Prefetcher {
+
+private:
+  int degree;
+
+public:
+  explicit NextLinePrefetcher(int degree) : degree(degree) {}
+  const char *name() const override { return "next-line"; }
+  void on_access(size_t line, bool hit, bool prefetched_hit,
+                 std::vector<size_t> &lines) override;
+};
+
+// Per-region stride detection. There are no PCs in the trace, so the
+// reference prediction table is indexed by 4 KB region; an entry issues
+// prefetches once the same stride has been seen twice in a row.
+class StridePrefetcher : public Prefetcher {
+
+private:
+  static const int TABLE_SIZE = 64;
+  static const int REGION_SHIFT = 12;
+  struct Entry {
+    bool valid = false;
+    size_t region = 0;
+    size_t last_line = 0;
+    long long stride = 0;
+    int confidence = 0;
+  };
+  Entry table[TABLE_SIZE];
+  int degree;
+  int line_shift;
+
+public:
+  StridePrefetcher(int degree, size_t block_size);
+  const char *name() const override { return "stride"; }
+  void on_access(size_t line, bool hit, bool prefetched_hit,
+                 std::vector<size_t> &lines) override;
+};
+
+// Jouppi-style stream buffers kept as sequential stream trackers: a miss
+// that does not continue a live stream allocates the least recently used
+// one, and every access that continues a stream keeps it `depth` lines
+// ahead of the demand stream.
+class StreamPrefetcher : public Prefetcher {
+
+private:
+  static const int NUM_STREAMS = 4;
+  struct Stream {
+    bool valid = false;
+    size_t expected = 0;
+    size_t prefetched_upto = 0;
+    size_t last_use = 0;
+  };
+  Stream streams[NUM_STREAMS];
+  int depth;
+  size_t clock = 0;
+
+public:
+  explicit StreamPrefetcher(int depth) : depth(depth) {}
+  const char *name() const override { return "stream"; }
+  void on_access(size_t line, bool hit, bool prefetched_hit,
+                 std::vector<size_t> &lines) override;
+};
+
+std::unique_ptr<Prefetcher> create_prefetcher(PrefetcherType type, int degree,
+                                              size_t block_size);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <vector>
+
+
+// Fixed-size object slabs carved out of pages that the owning MemoryManager
+// allocates from its free-list heap. Each page serves one size class and
+// tracks its slots in a 64-bit free bitmap.
+class SlabAllocator {
+
+private:
+  static const int NUM_CLASSES = 9;
+  static const size_t CLASS_SIZES[NUM_CLASSES];
+  struct SlabPage {
+    int size_class;
+    int capacity;
+    int used;
+    uint64_t free_slots;
+    size_t requested_bytes;
+    uint16_t requested[64];
+  };
+  std::map<char *, SlabPage> pages;
+  std::vector<char *> partial[NUM_CLASSES];
+  SlabPage *find_page(void *ptr, char *&start);
+  void remove_partial(int size_class, char *start);
+
+public:
+  static const size_t PAGE_SIZE = 512;
+  static const size_t MAX_OBJECT_SIZE = 256;
+  void reset();
+  int get_class(size_t size) const;
+  size_t get_class_size(int size_class) const;
+  void *malloc(size_t size);
+  void add_page(char *start, int size_class);
+  bool empty() const { return pages.empty(); }
+  bool owns(void *ptr);
+  char *free(void *ptr);
+  bool describe_page(void *start, size_t &class_size, int &used,
+                     int &capacity);
+  void print_stats();
+};
+
+#endif
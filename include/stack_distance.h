@@ -0,0 +1,94 @@
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+#include "cache.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// One LRU stack. Each tracked line owns a single mark at the time slot of
+// its last reference in a Fenwick tree, so the stack distance of a reuse is
+// the number of marks after that slot. Slots are renumbered once the tree
+// fills up, which bounds memory by the number of tracked lines instead of
+// the trace length.
+class LruStackCounter {
+
+private:
+  std::unordered_map<uint64_t, size_t> last_slot;
+  std::vector<int> tree;
+  size_t next_slot = 0;
+  void add(size_t slot, int delta);
+  int prefix(size_t slot) const;
+  void renumber();
+
+public:
+  static const size_t COLD = static_cast<size_t>(-1);
+  size_t access(uint64_t line);
+  void forget(uint64_t line);
+  size_t tracked() const { return last_slot.size(); }
+};
+
+// Single-pass Mattson analysis. Every reference updates one fully
+// associative stack and, for each power-of-two set count, the stack of the
+// set the line maps to, so one pass yields exact LRU miss ratios for every
+// cache size and associativity. SHARDS spatial sampling keeps only lines
+// whose hash falls under a threshold and scales their distances by 1 / rate;
+// with a sample cap the threshold is lowered whenever the cap is exceeded.
+// A sample says nothing about the unsampled lines sharing a set, so sampled
+// runs skip the per-set stacks and estimate set-associative miss ratios from
+// the fully associative distances with a binomial set-mapping model.
+class StackDistanceAnalyzer {
+
+private:
+  static const int MAX_SET_LOG2 = 12;
+  static const int SUB_BUCKETS = 16;
+  static const int NUM_BUCKETS = SUB_BUCKETS * 61;
+  static const uint64_t HASH_MODULUS = (uint64_t)1 << 24;
+  struct Shadow {
+    size_t lines;
+    size_t ways;
+    std::unique_ptr<CacheLevel> level;
+  };
+  struct Histogram {
+    double buckets[NUM_BUCKETS] = {};
+    double cold = 0;
+    void add(size_t distance, double scale);
+    double miss_ratio(size_t capacity, double total) const;
+    double assoc_miss_ratio(size_t sets, size_t ways, double total) const;
+    static int bucket_of(size_t distance);
+    static size_t lower_bound(int bucket);
+  };
+  bool enabled = false;
+  bool exact = true;
+  size_t block_size = 64;
+  uint64_t threshold = HASH_MODULUS;
+  size_t max_samples = 0;
+  size_t references = 0;
+  size_t sampled_references = 0;
+  LruStackCounter full;
+  Histogram full_hist;
+  std::vector<std::vector<LruStackCounter>> set_stacks;
+  Histogram set_hists[MAX_SET_LOG2 + 1];
+  std::set<std::pair<uint64_t, uint64_t>> samples;
+  std::vector<Shadow> shadows;
+  static uint64_t hash_line(uint64_t line);
+  double rate() const;
+  double predicted_miss_ratio(size_t lines, size_t ways) const;
+  void evict_sample();
+
+public:
+  void start(size_t block_size, double sampling_rate, size_t max_samples);
+  void stop() { enabled = false; }
+  bool is_enabled() const { return enabled; }
+  void record(size_t address);
+  bool analyze_file(const std::string &path);
+  void print_curve();
+};
+
+#endif
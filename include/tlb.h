@@ -0,0 +1,46 @@
+#ifndef TLB_H
+#define TLB_H
+#include "cache.h"
+#include <cstddef>
+#include <memory>
+
+
+// Two-level TLB: a private L1 dTLB in front of a larger shared L2 TLB. Each
+// level is a set-associative CacheLevel keyed by virtual page number with
+// one-entry "lines", so it gets the cache's replacement policies; the frame
+// itself is read from the page table, which shootdowns keep consistent.
+// Translation time is charged per lookup level plus one memory reference
+// per page-table level on a walk. Configuration survives init; state and
+// counters do not.
+class Tlb {
+
+private:
+  static const int NUM_LEVELS = 2;
+  struct Config {
+    size_t entries;
+    size_t ways;
+    CacheReplacementPolicy policy;
+  };
+  Config configs[NUM_LEVELS] = {{64, 4, CacheReplacementPolicy::LRU},
+                                {1536, 12, CacheReplacementPolicy::LRU}};
+  std::unique_ptr<CacheLevel> levels[NUM_LEVELS];
+  size_t latencies[NUM_LEVELS] = {1, 7};
+  size_t walk_latency = 30;
+  size_t lookups = 0;
+  size_t walks = 0;
+  size_t walk_references = 0;
+  size_t shootdowns = 0;
+  size_t cycles = 0;
+
+public:
+  void configure(int level, size_t entries, size_t ways,
+                 CacheReplacementPolicy policy);
+  void set_walk_latency(size_t cycles) { walk_latency = cycles; }
+  void reset();
+  bool lookup(size_t vpn);
+  void record_walk(int table_levels);
+  void invalidate(size_t vpn);
+  void print_stats() const;
+};
+
+#endif
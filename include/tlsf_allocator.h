@@ -0,0 +1,66 @@
+#ifndef TLSF_ALLOCATOR_H
+#define TLSF_ALLOCATOR_H
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+
+// In-band TLSF header. prev_phys is the offset of the physically previous
+// block; free blocks keep their free-list links in the first payload bytes.
+struct TLSFBlock {
+  uint32_t prev_phys;
+  uint32_t size_flags;
+};
+
+class TLSFAllocator {
+
+private:
+  static const int ALIGN_LOG2 = 3;
+  static const int SL_INDEX_LOG2 = 4;
+  static const int SL_INDEX_COUNT = 1 << SL_INDEX_LOG2;
+  static const int FL_INDEX_SHIFT = SL_INDEX_LOG2 + ALIGN_LOG2;
+  static const int FL_INDEX_MAX = 32;
+  static const int FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+  static const size_t SMALL_BLOCK_SIZE = (size_t)1 << FL_INDEX_SHIFT;
+  static const size_t MIN_PAYLOAD = 8;
+  static const uint32_t NIL = 0xFFFFFFFFu;
+  static const uint32_t FREE_BIT = 1;
+  char *memory_start;
+  size_t total_size;
+  uint32_t fl_bitmap;
+  uint32_t sl_bitmap[FL_INDEX_COUNT];
+  uint32_t blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+  std::unordered_map<uint32_t, size_t> requested_sizes;
+  size_t allocated_bytes = 0;
+  size_t requested_bytes = 0;
+  size_t free_list_bytes = 0;
+  bool verbose = true;
+  TLSFBlock *block_at(uint32_t offset);
+  uint32_t offset_of(TLSFBlock *block);
+  size_t block_size(TLSFBlock *block);
+  bool block_free(TLSFBlock *block);
+  TLSFBlock *next_phys(TLSFBlock *block);
+  uint32_t &next_free(TLSFBlock *block);
+  uint32_t &prev_free(TLSFBlock *block);
+  void mapping_insert(size_t size, int &fl, int &sl);
+  void mapping_search(size_t size, int &fl, int &sl);
+  TLSFBlock *search_suitable_block(int &fl, int &sl);
+  void insert_free_block(TLSFBlock *block);
+  void remove_free_block(TLSFBlock *block);
+  void set_block(TLSFBlock *block, size_t size, bool is_free);
+
+public:
+  TLSFAllocator();
+  void init(char *memory, size_t size);
+  void *malloc(size_t size);
+  void free(void *ptr);
+  bool owns(void *ptr);
+  size_t usable_size(void *ptr);
+  void set_verbose(bool v) { verbose = v; }
+  void collect_stats(size_t &used, size_t &free_bytes, size_t &internal_frag,
+                     size_t &largest_free);
+  void debug_lists();
+};
+
+#endif
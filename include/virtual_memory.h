@@ -4,46 +4,103 @@
 #include <deque>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
+#include "page_replacer.h"
+#include "page_table.h"
+#include "paging_disk.h"
+#include "tlb.h"
 
 
-struct PageTableEntry {
-  int frame_number = -1;
-  bool valid = false;
-  bool dirty = false;
-  bool reference_bit = false;   
-  size_t last_access_time = 0;  
-};
-
-enum class ReplacementPolicy { FIFO, LRU, CLOCK };
-
 class VirtualMemoryManager {
 
 private:
+  static constexpr size_t NO_PAGE = static_cast<size_t>(-1);
   size_t page_size;
-  std::vector<PageTableEntry> page_table;
-  std::vector<int> frame_table;
-  size_t total_frames;
+  size_t num_pages = 0;
+  RadixPageTable page_table;
+  std::vector<size_t> frame_table;
+  // Free frames are a stack; resident frames sit on an intrusive
+  // most-recently-used-first list so faults never scan the frame table.
+  struct FrameLink {
+    size_t prev;
+    size_t next;
+  };
+  std::vector<size_t> free_frames;
+  std::vector<FrameLink> lru_links;
+  size_t lru_head = NO_PAGE;
+  size_t lru_tail = NO_PAGE;
+  size_t total_frames = 0;
   ReplacementPolicy policy = ReplacementPolicy::FIFO;
+  std::unique_ptr<PageReplacer> replacer;
+  // WSClock evicts clean pages untouched for more than this many accesses
+  // and schedules write-back for dirty ones; 0 means one per frame.
+  size_t wsclock_window = 0;
+  size_t wsclock_cleanings = 0;
   std::deque<int>
       fifo_queue;  
   std::deque<size_t> fifo_pages;
   size_t access_counter = 0;  
   size_t clock_hand = 0;  
   int disk_latency_ms = 0;
+  int write_latency_ms = 0;
+  // Dirty victims are copied to a write-back buffer and written to swap
+  // together, one disk request per full batch. A fault on a page still in
+  // the buffer takes it back without a disk read.
+  size_t writeback_batch = 1;
+  std::vector<size_t> writeback_pages;
+  // Only pages with a copy in swap are swapped in; a page never written
+  // out is filled on its first touch, or again after a clean eviction.
+  size_t swap_ins = 0;
+  size_t fresh_page_ins = 0;
+  size_t swap_outs = 0;
+  size_t swap_writes = 0;
+  size_t swap_cache_hits = 0;
+  // Simulated clock in microseconds. Faults are asynchronous: the page-in
+  // is queued on the disk and the trace moves on, stalling only when it
+  // touches a page still in flight, evicts one, or finds the disk queue full.
+  uint64_t sim_time = 0;
+  uint64_t stall_time = 0;
+  uint64_t cpu_time_us = 1;
+  PagingDisk disk;
   size_t page_faults = 0;
   size_t page_hits = 0;
+  Tlb tlb;
   int find_free_frame();
-  int evict_page();
+  void lru_unlink(size_t frame);
+  void lru_push_front(size_t frame);
+  void stall_until(uint64_t time);
+  void queue_write_back(size_t page_idx);
+  void flush_write_backs();
+  void reset_policy_state();
+  size_t wsclock_victim();
+  int evict_page(size_t incoming);
 
 public:
-  void init(size_t page_size, size_t virtual_size, size_t physical_memory_size);
-  bool translate(size_t v_addr, size_t &p_addr);
+  void init(size_t page_size, int address_bits, size_t physical_memory_size);
+  bool translate(size_t v_addr, size_t &p_addr, bool is_write = false);
   void print_stats();
+  size_t get_page_size() const { return page_size; }
+  size_t get_total_frames() const { return total_frames; }
 
-  void set_policy(ReplacementPolicy p) { policy = p; }
+  void set_policy(ReplacementPolicy p, size_t window = 0);
 
-  void set_disk_latency(int ms) { disk_latency_ms = ms; }
+  void set_disk_latency(int read_ms, int write_ms) {
+    disk_latency_ms = read_ms;
+    write_latency_ms = write_ms;
+  }
+  void set_writeback_batch(size_t pages) {
+    writeback_batch = pages == 0 ? 1 : pages;
+  }
+  void configure_disk(size_t channels, size_t queue_depth) {
+    disk.configure(channels, queue_depth);
+  }
+  void set_cpu_time(uint64_t us) { cpu_time_us = us; }
+  void configure_tlb(int level, size_t entries, size_t ways,
+                     CacheReplacementPolicy policy) {
+    tlb.configure(level, entries, ways, policy);
+  }
+  void set_walk_latency(size_t cycles) { tlb.set_walk_latency(cycles); }
 };
 
 #endif
\ No newline at end of file
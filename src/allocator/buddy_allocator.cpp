@@ -1,10 +1,13 @@
 #include "../../include/buddy_allocator.h"
 
 BuddyAllocator::BuddyAllocator()
-    : memory_start(nullptr), total_size(0), min_order(0), max_order(0) {
+    : order_mask(0), allocated_bytes(0), requested_bytes(0),
+      memory_start(nullptr), total_size(0), min_order(0), max_order(0) {
 
   for (int i = 0; i < MAX_LEVELS; ++i) {
-    free_lists[i] = nullptr;
+    free_counts[i] = 0;
+    first_word_hint[i] = 0;
+    alloc_counts[i] = 0;
   }
 }
 
@@ -24,6 +27,64 @@ size_t BuddyAllocator::get_size_from_order(int order) {
   return (size_t)1 << order;
 }
 
+bool BuddyAllocator::test_free(int order, size_t offset) {
+  size_t bit = offset >> order;
+  return (free_maps[order][bit / 64] >> (bit % 64)) & 1;
+}
+
+void BuddyAllocator::mark_free(int order, size_t offset) {
+  size_t bit = offset >> order;
+  free_maps[order][bit / 64] |= (uint64_t)1 << (bit % 64);
+  if (bit / 64 < first_word_hint[order])
+    first_word_hint[order] = bit / 64;
+  free_counts[order]++;
+  order_mask |= (uint64_t)1 << order;
+}
+
+void BuddyAllocator::clear_free(int order, size_t offset) {
+  size_t bit = offset >> order;
+  free_maps[order][bit / 64] &= ~((uint64_t)1 << (bit % 64));
+  free_counts[order]--;
+  if (free_counts[order] == 0)
+    order_mask &= ~((uint64_t)1 << order);
+}
+
+// Lowest-addressed free block of the order. The hint only ever points at or
+// before the first non-empty word, so the scan is amortised over the frees
+// that moved it back.
+size_t BuddyAllocator::take_first_free(int order) {
+  std::vector<uint64_t> &map = free_maps[order];
+  size_t word = first_word_hint[order];
+
+  while (word < map.size() && map[word] == 0) {
+    word++;
+  }
+
+  first_word_hint[order] = word;
+  if (word == map.size())
+    return NPOS;
+  size_t bit = word * 64 + __builtin_ctzll(map[word]);
+  size_t offset = bit << order;
+  clear_free(order, offset);
+  return offset;
+}
+
+void BuddyAllocator::record_alloc(size_t offset, int order, size_t size) {
+  alloc_orders[offset >> min_order] = static_cast<uint8_t>(order + 1);
+  alloc_counts[order]++;
+  allocated_bytes += get_size_from_order(order);
+  requested_bytes += size;
+  requested_sizes[offset] = size;
+}
+
+void BuddyAllocator::record_free(size_t offset, int order) {
+  alloc_orders[offset >> min_order] = 0;
+  alloc_counts[order]--;
+  allocated_bytes -= get_size_from_order(order);
+  requested_bytes -= requested_sizes[offset];
+  requested_sizes.erase(offset);
+}
+
 void BuddyAllocator::init(char *memory, size_t size) {
   this->memory_start = memory;
   this->total_size = size;
@@ -35,147 +96,215 @@ void BuddyAllocator::init(char *memory, size_t size) {
 
   this->total_size = get_size_from_order(max_order);
   min_order = get_order(MIN_BLOCK_SIZE);
-  BlockHeader *root = reinterpret_cast<BlockHeader *>(memory_start);
-  root->size = this->total_size - sizeof(BlockHeader);
-  root->is_free = true;
-  root->next = nullptr;
-  root->prev = nullptr;
-  root->id = 0;
-  root->size = get_size_from_order(max_order) - sizeof(BlockHeader);
-  free_lists[max_order] = root;
+  order_mask = 0;
+  allocated_bytes = 0;
+  requested_bytes = 0;
+  requested_sizes.clear();
+
+  for (int i = 0; i < MAX_LEVELS; ++i) {
+    free_maps[i].clear();
+    free_counts[i] = 0;
+    first_word_hint[i] = 0;
+    alloc_counts[i] = 0;
+  }
+
+  if (max_order < min_order) {
+    std::cout << "Buddy Allocator: Memory too small." << std::endl;
+    this->total_size = 0;
+    alloc_orders.clear();
+    return;
+  }
+
+  for (int order = min_order; order <= max_order; ++order) {
+    size_t blocks = this->total_size >> order;
+    free_maps[order].assign((blocks + 63) / 64, 0);
+  }
+
+  alloc_orders.assign(this->total_size >> min_order, 0);
+  mark_free(max_order, 0);
   std::cout << "Buddy Allocator Initialized. Total Size: " << this->total_size
             << " (Order " << max_order << ")" << std::endl;
 }
 
-BlockHeader *BuddyAllocator::get_block(int order) {
+// Takes a block from the smallest non-empty order at or above the request
+// and splits it down, handing each upper half to the order below.
+size_t BuddyAllocator::get_block(int order) {
   if (order > max_order)
-    return nullptr;
+    return NPOS;
+  uint64_t candidates = order_mask & (~(uint64_t)0 << order);
+  if (!candidates)
+    return NPOS;
+  int current = __builtin_ctzll(candidates);
+  size_t offset = take_first_free(current);
+  if (offset == NPOS)
+    return NPOS;
 
-  if (free_lists[order] != nullptr) {
-    BlockHeader *block = free_lists[order];
-    free_lists[order] = block->next;
-    if (free_lists[order])
-      free_lists[order]->prev = nullptr;
-    block->next = nullptr;
-    block->prev = nullptr;
-    block->is_free = false;
-    return block;
+  while (current > order) {
+    current--;
+    mark_free(current, offset + get_size_from_order(current));
   }
 
-  BlockHeader *larger = get_block(order + 1);
-  if (!larger)
-    return nullptr;
-  size_t size = get_size_from_order(order);
-  BlockHeader *buddy =
-      reinterpret_cast<BlockHeader *>(reinterpret_cast<char *>(larger) + size);
-  buddy->is_free = true;
-  buddy->size = size - sizeof(BlockHeader);
-  buddy->next = free_lists[order];
-  buddy->prev = nullptr;
-  if (free_lists[order])
-    free_lists[order]->prev = buddy;
-  free_lists[order] = buddy;
-  larger->size = size - sizeof(BlockHeader);
-  larger->is_free = false;
-  return larger;
+  return offset;
 }
 
 void *BuddyAllocator::malloc(size_t size) {
-  size_t total_needed = size + sizeof(BlockHeader);
-  int order = get_order(total_needed);
+  int order = get_order(size);
   if (order < min_order)
     order = min_order;
-  BlockHeader *block = get_block(order);
+  size_t offset = get_block(order);
 
-  if (!block) {
+  if (offset == NPOS) {
     std::cout << "Buddy Allocator: No memory available." << std::endl;
     return nullptr;
   }
 
-  block->is_free = false;
+  record_alloc(offset, order, size);
   std::cout << "Buddy Alloc: Order " << order << " ("
             << get_size_from_order(order) << " bytes)" << std::endl;
-  return reinterpret_cast<char *>(block) + sizeof(BlockHeader);
+  return memory_start + offset;
+}
+
+bool BuddyAllocator::owns(void *ptr) {
+  char *p = static_cast<char *>(ptr);
+  if (memory_start == nullptr || p < memory_start ||
+      p >= memory_start + total_size)
+    return false;
+  size_t offset = static_cast<size_t>(p - memory_start);
+  if (offset & (get_size_from_order(min_order) - 1))
+    return false;
+  return alloc_orders[offset >> min_order] != 0;
 }
 
 void BuddyAllocator::free(void *ptr) {
   if (!ptr)
     return;
-  BlockHeader *block = reinterpret_cast<BlockHeader *>(
-      reinterpret_cast<char *>(ptr) - sizeof(BlockHeader));
-  size_t block_total_size = block->size + sizeof(BlockHeader);
-  int order = get_order(block_total_size);
-  char *block_addr = reinterpret_cast<char *>(block);
+
+  if (!owns(ptr)) {
+    std::cout << "Error: Invalid address. Pointer is not the start of an "
+                 "allocated block."
+              << std::endl;
+    return;
+  }
+
+  size_t offset = static_cast<size_t>(static_cast<char *>(ptr) - memory_start);
+  int order = alloc_orders[offset >> min_order] - 1;
+  record_free(offset, order);
 
   while (order < max_order) {
-    size_t buddy_size = get_size_from_order(order);
-    size_t relative_offset = (size_t)(block_addr - memory_start);
-    size_t buddy_offset = relative_offset ^ buddy_size;
-    char *buddy_addr = memory_start + buddy_offset;
+    size_t buddy_offset = offset ^ get_size_from_order(order);
 
-    // Bounds check
-    if (buddy_addr < memory_start || buddy_addr >= memory_start + total_size) {
+    if (!test_free(order, buddy_offset)) {
       break;
     }
 
-    BlockHeader *buddy = reinterpret_cast<BlockHeader *>(buddy_addr);
-    size_t buddy_current_total = buddy->size + sizeof(BlockHeader);
+    std::cout << "Merging with buddy at " << buddy_offset << " (Order "
+              << order << ")" << std::endl;
+    clear_free(order, buddy_offset);
+    if (buddy_offset < offset)
+      offset = buddy_offset;
+    order++;
+  }
 
-    bool buddy_is_free_at_level = false;
-    if (buddy->is_free && buddy_current_total == buddy_size) {
-      buddy_is_free_at_level = true;
-    }
+  mark_free(order, offset);
+}
 
-    if (buddy_is_free_at_level) {
-      std::cout << "Merging with buddy at " << buddy_offset << " (Order "
-                << order << ")" << std::endl;
-      if (buddy->prev)
-        buddy->prev->next = buddy->next;
-      if (buddy->next)
-        buddy->next->prev = buddy->prev;
-      if (free_lists[order] == buddy)
-        free_lists[order] = buddy->next;
-
-      if (buddy_addr < block_addr) {
-        block = buddy;
-        block_addr = buddy_addr;
-      }
+size_t BuddyAllocator::usable_size(void *ptr) {
+  size_t offset = static_cast<size_t>(static_cast<char *>(ptr) - memory_start);
+  return get_size_from_order(alloc_orders[offset >> min_order] - 1);
+}
 
-      order++;
-      block->size = get_size_from_order(order) - sizeof(BlockHeader);
-    } else {
-      break;
+// Shrinking hands the upper halves back to the lower orders; their buddies
+// are the still-allocated lower halves, so nothing can merge. Growing only
+// works when the block is aligned for the target order and every buddy on
+// the way up is wholly free at its own order.
+bool BuddyAllocator::resize_in_place(void *ptr, size_t size) {
+  size_t offset = static_cast<size_t>(static_cast<char *>(ptr) - memory_start);
+  int order = alloc_orders[offset >> min_order] - 1;
+  int new_order = get_order(size);
+  if (new_order < min_order)
+    new_order = min_order;
+
+  if (new_order <= order) {
+    record_free(offset, order);
+
+    while (order > new_order) {
+      order--;
+      mark_free(order, offset + get_size_from_order(order));
     }
+
+    record_alloc(offset, new_order, size);
+    return true;
   }
 
-  block->is_free = true;
-  block->next = free_lists[order];
-  block->prev = nullptr;
-  if (free_lists[order])
-    free_lists[order]->prev = block;
-  free_lists[order] = block;
+  if (new_order > max_order || (offset & (get_size_from_order(new_order) - 1)))
+    return false;
+
+  for (int o = order; o < new_order; ++o) {
+    if (!test_free(o, offset + get_size_from_order(o)))
+      return false;
+  }
+
+  for (int o = order; o < new_order; ++o) {
+    std::cout << "Absorbing buddy at " << offset + get_size_from_order(o)
+              << " (Order " << o << ")" << std::endl;
+    clear_free(o, offset + get_size_from_order(o));
+  }
+
+  record_free(offset, order);
+  record_alloc(offset, new_order, size);
+  return true;
+}
+
+void BuddyAllocator::collect_stats(size_t &used, size_t &free_bytes,
+                                   size_t &internal_frag,
+                                   size_t &largest_free) {
+  used = allocated_bytes;
+  free_bytes = total_size - allocated_bytes;
+  internal_frag = allocated_bytes - requested_bytes;
+  largest_free =
+      order_mask ? get_size_from_order(63 - __builtin_clzll(order_mask)) : 0;
+}
+
+void BuddyAllocator::print_order_stats() {
+  std::cout << "Buddy Orders:" << std::endl;
+
+  for (int order = min_order; order <= max_order; ++order) {
+    if (free_counts[order] == 0 && alloc_counts[order] == 0)
+      continue;
+    std::cout << "  Order " << order << " (" << get_size_from_order(order)
+              << " bytes): " << free_counts[order] << " free, "
+              << alloc_counts[order] << " allocated" << std::endl;
+  }
 }
 
 void BuddyAllocator::debug_lists() {
   std::cout << "--- Buddy Memory Map ---" << std::endl;
 
-  char *current = (char *)memory_start;
-  char *end = current + total_size;
+  size_t offset = 0;
 
-  while (current < end) {
-    BlockHeader *block = reinterpret_cast<BlockHeader *>(current);
+  while (offset < total_size) {
+    int order = alloc_orders[offset >> min_order] - 1;
+    bool allocated = order >= 0;
 
-    // Calculate true block size (payload + header)
-    // Note: block->size stores payload.
-    // Total size must be power of 2.
-    size_t total_block_size = block->size + sizeof(BlockHeader);
+    if (!allocated) {
+      order = max_order;
 
-    std::cout << "  Address " << (size_t)(current - (char *)memory_start)
-              << " | Size: " << total_block_size
-              << " | Status: " << (block->is_free ? "FREE" : "ALLOCATED")
+      while (order > min_order &&
+             ((offset & (get_size_from_order(order) - 1)) ||
+              !test_free(order, offset))) {
+        order--;
+      }
+    }
+
+    size_t block_size = get_size_from_order(order);
+    std::cout << "  Address " << offset << " | Size: " << block_size
+              << " | Status: " << (allocated ? "ALLOCATED" : "FREE")
               << std::endl;
 
-    current += total_block_size;
+    offset += block_size;
   }
+
+  std::cout << "  Free orders mask: 0x" << std::hex << order_mask << std::dec
+            << std::endl;
   std::cout << "------------------------" << std::endl;
-}
\ No newline at end of file
+}
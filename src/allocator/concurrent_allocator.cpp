@@ -0,0 +1,410 @@
+#include "../../include/concurrent_allocator.h"
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+const size_t ConcurrentAllocator::CLASS_SIZES[ConcurrentAllocator::NUM_CLASSES] =
+    {16, 32, 64, 128, 256};
+
+int ConcurrentAllocator::get_class(size_t size) const {
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+
+    if (size <= CLASS_SIZES[i]) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+int ConcurrentAllocator::arena_of(void *ptr) const {
+  char *p = static_cast<char *>(ptr);
+  if (memory_start == nullptr || arena_size == 0 || p < memory_start)
+    return -1;
+  size_t index = static_cast<size_t>(p - memory_start) / arena_size;
+  if (index >= arenas.size())
+    return -1;
+  return static_cast<int>(index);
+}
+
+void ConcurrentAllocator::init(char *memory, size_t size, int num_arenas) {
+  if (num_arenas < 1)
+    num_arenas = 1;
+  memory_start = memory;
+  arena_size = (size / num_arenas) & ~(size_t)7;
+  arenas.clear();
+
+  for (int i = 0; i < num_arenas; ++i) {
+    arenas.push_back(std::unique_ptr<Arena>(new Arena()));
+    arenas.back()->heap.set_verbose(false);
+    arenas.back()->heap.init(memory + i * arena_size, arena_size);
+  }
+
+  next_home = 0;
+  cache_hits = 0;
+  refills = 0;
+  flushes = 0;
+  if (verbose)
+    std::cout << "Concurrent Allocator Initialized: " << num_arenas
+              << " arena(s) x " << arena_size << " bytes" << std::endl;
+}
+
+void ConcurrentAllocator::lock_arena(Arena &arena) {
+  if (!arena.lock.try_lock()) {
+    arena.contended_locks.fetch_add(1, std::memory_order_relaxed);
+    arena.lock.lock();
+  }
+
+  arena.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Caller holds the arena lock. The whole stack is detached in one exchange,
+// so producers never wait on the owner.
+void ConcurrentAllocator::drain_remote_frees(Arena &arena) {
+  RemoteNode *node = arena.remote_frees.exchange(nullptr,
+                                                 std::memory_order_acquire);
+
+  while (node != nullptr) {
+    RemoteNode *next = node->next;
+    arena.heap.free(node);
+    node = next;
+  }
+}
+
+void ConcurrentAllocator::push_remote(Arena &arena, void *ptr) {
+  RemoteNode *node = static_cast<RemoteNode *>(ptr);
+  RemoteNode *head = arena.remote_frees.load(std::memory_order_relaxed);
+
+  do {
+    node->next = head;
+  } while (!arena.remote_frees.compare_exchange_weak(
+      head, node, std::memory_order_release, std::memory_order_relaxed));
+
+  arena.remote_free_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ConcurrentAllocator::bind(ThreadCache &cache) {
+  if (cache.home_arena < 0)
+    cache.home_arena = next_home.fetch_add(1) % get_num_arenas();
+}
+
+void *ConcurrentAllocator::malloc(ThreadCache &cache, size_t size) {
+  if (arenas.empty())
+    return nullptr;
+  bind(cache);
+  Arena &home = *arenas[cache.home_arena];
+  int size_class = get_class(size);
+
+  if (size_class < 0) {
+    lock_arena(home);
+    drain_remote_frees(home);
+    void *ptr = home.heap.malloc(size);
+    home.lock.unlock();
+    if (verbose)
+      std::cout << "Concurrent Alloc: Arena " << cache.home_arena
+                << " (large, " << size << " bytes)" << std::endl;
+    return ptr;
+  }
+
+  std::vector<void *> &bin = cache.bins[size_class];
+
+  if (!bin.empty()) {
+    cache.hits++;
+  } else {
+    lock_arena(home);
+    drain_remote_frees(home);
+
+    for (size_t i = 0; i < BATCH_SIZE; ++i) {
+      void *ptr = home.heap.malloc(CLASS_SIZES[size_class]);
+      if (!ptr)
+        break;
+      bin.push_back(ptr);
+    }
+
+    home.lock.unlock();
+    cache.refills++;
+
+    if (bin.empty()) {
+      return nullptr;
+    }
+  }
+
+  void *ptr = bin.back();
+  bin.pop_back();
+  if (verbose)
+    std::cout << "Concurrent Alloc: Arena " << cache.home_arena << ", class "
+              << CLASS_SIZES[size_class] << " (" << bin.size()
+              << " left in thread cache)" << std::endl;
+  return ptr;
+}
+
+void ConcurrentAllocator::free(ThreadCache &cache, void *ptr) {
+  if (!ptr || arenas.empty())
+    return;
+  bind(cache);
+  int owner = arena_of(ptr);
+  if (owner < 0)
+    return;
+
+  if (owner != cache.home_arena) {
+    push_remote(*arenas[owner], ptr);
+    if (verbose)
+      std::cout << "Concurrent Free: queued for arena " << owner << std::endl;
+    return;
+  }
+
+  Arena &home = *arenas[owner];
+  size_t usable = home.heap.usable_size(ptr);
+  int size_class = get_class(usable);
+
+  if (size_class < 0 || CLASS_SIZES[size_class] != usable) {
+    lock_arena(home);
+    drain_remote_frees(home);
+    home.heap.free(ptr);
+    home.lock.unlock();
+    if (verbose)
+      std::cout << "Concurrent Free: returned to arena " << owner << std::endl;
+    return;
+  }
+
+  std::vector<void *> &bin = cache.bins[size_class];
+  bin.push_back(ptr);
+
+  if (bin.size() > CACHE_LIMIT) {
+    lock_arena(home);
+
+    for (size_t i = 0; i < BATCH_SIZE; ++i) {
+      home.heap.free(bin.back());
+      bin.pop_back();
+    }
+
+    home.lock.unlock();
+    cache.flushes++;
+  }
+
+  if (verbose)
+    std::cout << "Concurrent Free: cached in class " << CLASS_SIZES[size_class]
+              << " (" << bin.size() << " cached)" << std::endl;
+}
+
+// Returns every cached object to the home arena and folds the cache's
+// counters into the allocator totals. Called when a thread retires.
+void ConcurrentAllocator::flush(ThreadCache &cache) {
+  if (cache.home_arena >= 0 && cache.home_arena < get_num_arenas()) {
+    Arena &home = *arenas[cache.home_arena];
+    lock_arena(home);
+    drain_remote_frees(home);
+
+    for (int i = 0; i < NUM_CLASSES; ++i) {
+
+      for (void *ptr : cache.bins[i]) {
+        home.heap.free(ptr);
+      }
+
+      cache.bins[i].clear();
+    }
+
+    home.lock.unlock();
+  }
+
+  cache_hits += cache.hits;
+  refills += cache.refills;
+  flushes += cache.flushes;
+  cache.hits = cache.refills = cache.flushes = 0;
+}
+
+bool ConcurrentAllocator::owns(ThreadCache &cache, void *ptr) {
+  int owner = arena_of(ptr);
+  if (owner < 0)
+    return false;
+  Arena &arena = *arenas[owner];
+
+  {
+    std::lock_guard<std::mutex> guard(arena.lock);
+    if (!arena.heap.owns(ptr))
+      return false;
+  }
+
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+
+    for (void *cached : cache.bins[i]) {
+      if (cached == ptr)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+void ConcurrentAllocator::collect_stats(size_t &used, size_t &free_bytes,
+                                        size_t &internal_frag,
+                                        size_t &largest_free) {
+  used = free_bytes = internal_frag = largest_free = 0;
+
+  for (auto &arena : arenas) {
+    size_t a_used, a_free, a_frag, a_largest;
+    std::lock_guard<std::mutex> guard(arena->lock);
+    arena->heap.collect_stats(a_used, a_free, a_frag, a_largest);
+    used += a_used;
+    free_bytes += a_free;
+    internal_frag += a_frag;
+    if (a_largest > largest_free)
+      largest_free = a_largest;
+  }
+}
+
+void ConcurrentAllocator::print_stats(ThreadCache &cache) {
+  std::cout << "=== Concurrent Allocator Statistics ===" << std::endl;
+
+  for (size_t i = 0; i < arenas.size(); ++i) {
+    Arena &arena = *arenas[i];
+    std::cout << "  Arena " << i << ": " << arena.lock_acquisitions
+              << " lock(s), " << arena.contended_locks << " contended, "
+              << arena.remote_free_count << " remote free(s)" << std::endl;
+  }
+
+  size_t cached = 0;
+
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+    cached += cache.bins[i].size();
+  }
+
+  std::cout << "  Thread Cache Hits: " << cache_hits + cache.hits
+            << ", Refills: " << refills + cache.refills
+            << ", Flushes: " << flushes + cache.flushes << std::endl;
+  std::cout << "  Objects Held in Thread Cache: " << cached << std::endl;
+  std::cout << "=======================================\n" << std::endl;
+}
+
+void ConcurrentAllocator::debug_lists() {
+  for (size_t i = 0; i < arenas.size(); ++i) {
+    std::cout << "Arena " << i << " (base address " << i * arena_size << ")"
+              << std::endl;
+    std::lock_guard<std::mutex> guard(arenas[i]->lock);
+    arenas[i]->heap.debug_lists();
+  }
+}
+
+// Each worker keeps a ring of live objects, replacing a random slot on every
+// step. One allocation in sixteen is handed to the next thread through a
+// single-slot mailbox so that it is freed remotely.
+void ConcurrentAllocator::run_benchmark(int max_threads, size_t ops_per_thread) {
+  if (arenas.empty() || max_threads < 1)
+    return;
+  const size_t LIVE_SLOTS = 64;
+  int num_arenas = get_num_arenas();
+  size_t total = arena_size * num_arenas;
+  std::vector<int> thread_counts;
+
+  for (int t = 1; t < max_threads; t *= 2) {
+    thread_counts.push_back(t);
+  }
+
+  thread_counts.push_back(max_threads);
+  bool was_verbose = verbose;
+  verbose = false;
+  double base_rate = 0.0;
+  std::cout << "=== Concurrent Allocator Benchmark ===" << std::endl;
+  std::cout << "  Arenas: " << num_arenas << ", Ops per Thread: "
+            << ops_per_thread << std::endl;
+  std::cout << "  Threads | Allocs/sec | Speedup | Contended Locks | "
+               "Remote Frees | Failed"
+            << std::endl;
+
+  for (int threads : thread_counts) {
+    init(memory_start, total, num_arenas);
+    std::vector<std::atomic<void *>> mailboxes(threads);
+    for (auto &mailbox : mailboxes)
+      mailbox.store(nullptr);
+    std::atomic<size_t> allocs{0};
+    std::atomic<size_t> failed{0};
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int id = 0; id < threads; ++id) {
+      workers.emplace_back([&, id]() {
+        ThreadCache cache;
+        std::vector<void *> live(LIVE_SLOTS, nullptr);
+        uint32_t rng = 2463534242u + id * 7919u;
+        size_t local_allocs = 0;
+        size_t local_failed = 0;
+
+        for (size_t op = 0; op < ops_per_thread; ++op) {
+          rng ^= rng << 13;
+          rng ^= rng >> 17;
+          rng ^= rng << 5;
+          size_t slot = rng % LIVE_SLOTS;
+          free(cache, live[slot]);
+          live[slot] = nullptr;
+          size_t size = ((rng >> 8) % 32 == 0) ? 512 + (rng >> 13) % 1536
+                                               : 8 + (rng >> 13) % 249;
+          void *ptr = malloc(cache, size);
+
+          if (!ptr) {
+            local_failed++;
+          } else {
+            local_allocs++;
+
+            if (threads > 1 && (rng >> 24) % 16 == 0) {
+              void *old = mailboxes[(id + 1) % threads].exchange(ptr);
+              free(cache, old);
+            } else {
+              live[slot] = ptr;
+            }
+          }
+
+          free(cache, mailboxes[id].exchange(nullptr));
+        }
+
+        for (void *ptr : live) {
+          free(cache, ptr);
+        }
+
+        free(cache, mailboxes[id].exchange(nullptr));
+        flush(cache);
+        allocs += local_allocs;
+        failed += local_failed;
+      });
+    }
+
+    for (auto &worker : workers) {
+      worker.join();
+    }
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    ThreadCache leftovers;
+
+    for (auto &mailbox : mailboxes) {
+      free(leftovers, mailbox.exchange(nullptr));
+    }
+
+    flush(leftovers);
+    size_t contended = 0;
+    size_t acquisitions = 0;
+    size_t remote = 0;
+
+    for (auto &arena : arenas) {
+      contended += arena->contended_locks;
+      acquisitions += arena->lock_acquisitions;
+      remote += arena->remote_free_count;
+    }
+
+    double rate = seconds > 0 ? allocs / seconds : 0.0;
+    if (threads == thread_counts.front())
+      base_rate = rate;
+    double contention =
+        acquisitions > 0 ? static_cast<double>(contended) / acquisitions * 100.0
+                         : 0.0;
+    std::cout << "  " << threads << " | " << static_cast<size_t>(rate) << " | "
+              << (base_rate > 0 ? rate / base_rate : 0.0) << "x | "
+              << contention << "% | " << remote << " | " << failed
+              << std::endl;
+  }
+
+  init(memory_start, total, num_arenas);
+  verbose = was_verbose;
+  std::cout << "  (Arenas reset after benchmark)" << std::endl;
+  std::cout << "======================================\n" << std::endl;
+}
@@ -0,0 +1,96 @@
+#include "../../include/free_block_index.h"
+
+int FreeBlockIndex::get_bin(size_t size) const {
+  int bin = 0;
+
+  while (size > 1 && bin < NUM_BINS - 1) {
+    size >>= 1;
+    bin++;
+  }
+
+  return bin;
+}
+
+void FreeBlockIndex::clear() {
+  for (int i = 0; i < NUM_BINS; ++i) {
+    bins[i].clear();
+  }
+
+  by_size.clear();
+  free_bytes = 0;
+}
+
+void FreeBlockIndex::insert(size_t offset, size_t size) {
+  bins[get_bin(size)][offset] = size;
+  by_size.insert({size, offset});
+  free_bytes += size;
+}
+
+void FreeBlockIndex::erase(size_t offset, size_t size) {
+  bins[get_bin(size)].erase(offset);
+  by_size.erase({size, offset});
+  free_bytes -= size;
+}
+
+// Lowest-addressed free block with enough room. Every block in a class above
+// the request's own class is large enough, so only the head of those classes
+// matters; the request's class is scanned in address order until it can no
+// longer beat the best candidate found above it.
+size_t FreeBlockIndex::find_first_fit(size_t size) const {
+  int start_bin = get_bin(size);
+  size_t best = NPOS;
+
+  for (int b = start_bin + 1; b < NUM_BINS; ++b) {
+
+    if (!bins[b].empty() && bins[b].begin()->first < best) {
+      best = bins[b].begin()->first;
+    }
+  }
+
+  for (const auto &entry : bins[start_bin]) {
+
+    if (entry.first >= best)
+      break;
+
+    if (entry.second >= size) {
+      return entry.first;
+    }
+  }
+
+  return best;
+}
+
+// Smallest block that fits; ties go to the lowest address.
+size_t FreeBlockIndex::find_best_fit(size_t size) const {
+  auto it = by_size.lower_bound({size, 0});
+  if (it == by_size.end())
+    return NPOS;
+  return it->second;
+}
+
+// Largest block; ties go to the lowest address.
+size_t FreeBlockIndex::find_worst_fit(size_t size) const {
+  if (by_size.empty())
+    return NPOS;
+  size_t largest = by_size.rbegin()->first;
+  if (largest < size || largest == 0)
+    return NPOS;
+  return by_size.lower_bound({largest, 0})->second;
+}
+
+size_t FreeBlockIndex::largest() const {
+  if (by_size.empty())
+    return 0;
+  return by_size.rbegin()->first;
+}
+
+void FreeBlockIndex::print_histogram() const {
+  std::cout << "Free Block Histogram:" << std::endl;
+
+  for (int b = 0; b < NUM_BINS; ++b) {
+    if (bins[b].empty())
+      continue;
+    std::cout << "  [" << ((size_t)1 << b) << ", " << ((size_t)1 << (b + 1))
+              << "): " << bins[b].size() << std::endl;
+  }
+}
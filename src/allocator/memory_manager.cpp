@@ -1,7 +1,10 @@
 #include "../../include/memory_manager.h"
 #include <algorithm>
 #include <alloca.h>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <ostream>
 
@@ -29,101 +32,202 @@ void MemoryManager::set_strategy(AllocationStrategy strategy) {
     buddy_system.init(memory.data(), total_size);
   }
 
+  if (strategy == AllocationStrategy::TLSF &&
+      current_strategy != AllocationStrategy::TLSF) {
+    std::cout << "Warning: Switching to TLSF at runtime. Initializing "
+                 "TLSF Allocator..."
+              << std::endl;
+    tlsf_system.init(memory.data(), total_size);
+  }
+
+  if (strategy == AllocationStrategy::CONCURRENT &&
+      current_strategy != AllocationStrategy::CONCURRENT) {
+    std::cout << "Warning: Switching to Concurrent Arenas at runtime. "
+                 "Initializing Concurrent Allocator..."
+              << std::endl;
+    main_thread_cache = ConcurrentAllocator::ThreadCache();
+    concurrent_system.init(memory.data(), total_size, concurrent_arenas);
+  }
+
   current_strategy = strategy;
 }
 
+void MemoryManager::set_arena_count(int arenas) {
+  concurrent_arenas = arenas < 1 ? 1 : arenas;
+}
+
+void MemoryManager::run_benchmark(int max_threads, size_t ops_per_thread) {
+  if (current_strategy != AllocationStrategy::CONCURRENT) {
+    std::cout << "Error: Benchmark requires the concurrent allocator. Run "
+                 "'set allocator concurrent <arenas>' first."
+              << std::endl;
+    return;
+  }
+
+  main_thread_cache = ConcurrentAllocator::ThreadCache();
+  concurrent_system.run_benchmark(max_threads, ops_per_thread);
+}
+
+void MemoryManager::init_cache() {
+  const size_t(&g)[3][3] = cache_geometry;
+  cache_system.init(g[0][0], g[0][1], g[0][2], g[1][0], g[1][1], g[1][2],
+                    g[2][0], g[2][1], g[2][2]);
+}
+
+void MemoryManager::set_cache_geometry(int level, size_t size,
+                                       size_t block_size, size_t ways) {
+  cache_geometry[level - 1][0] = size;
+  cache_geometry[level - 1][1] = block_size;
+  cache_geometry[level - 1][2] = ways;
+  init_cache();
+}
+
+void MemoryManager::set_cache_specialization(bool enabled) {
+  ::set_cache_specialization(enabled);
+  init_cache();
+}
+
 void MemoryManager::set_cache_policy(CacheReplacementPolicy policy) {
   cache_system.set_policy(policy);
+  multicore.set_policy(policy);
 }
 
-void MemoryManager::set_vm_policy(ReplacementPolicy policy) {
-  vm_system.set_policy(policy);
+void MemoryManager::set_cache_prefetcher(int level, PrefetcherType type,
+                                         int degree) {
+  cache_system.set_prefetcher(level, type, degree);
 }
 
-void MemoryManager::set_vm_latency(int ms) { vm_system.set_disk_latency(ms); }
-
-BlockHeader *MemoryManager::find_first_fit(size_t size) {
-  BlockHeader *current = head;
+void MemoryManager::set_cache_latency(int level, size_t cycles) {
+  cache_system.set_latency(level, cycles);
+}
 
-  while (current != nullptr) {
+void MemoryManager::set_cache_write_policy(int level, bool write_through,
+                                           bool write_allocate) {
+  cache_system.set_write_policy(level, write_through, write_allocate);
+}
 
-    if (current->is_free && current->size >= size) {
-      return current;
-    }
+void MemoryManager::set_cache_write_buffer(size_t entries) {
+  cache_system.set_write_buffer(entries);
+}
 
-    current = current->next;
-  }
+void MemoryManager::set_cache_inclusion(InclusionPolicy policy) {
+  cache_system.set_inclusion(policy);
+}
 
-  return nullptr;
+void MemoryManager::set_cache_victim_entries(size_t entries) {
+  cache_system.set_victim_cache(entries);
 }
 
-BlockHeader *MemoryManager::find_best_fit(size_t size) {
-  BlockHeader *current = head;
-  BlockHeader *best_block = nullptr;
-  size_t smallest_diff = static_cast<size_t>(-1);
+void MemoryManager::set_vm_policy(ReplacementPolicy policy, size_t window) {
+  vm_system.set_policy(policy, window);
+}
 
-  while (current != nullptr) {
+void MemoryManager::set_vm_latency(int read_ms, int write_ms) {
+  vm_system.set_disk_latency(read_ms, write_ms);
+}
 
-    if (current->is_free && current->size >= size) {
-      size_t diff = current->size - size;
+void MemoryManager::set_vm_writeback_batch(size_t pages) {
+  vm_system.set_writeback_batch(pages);
+}
 
-      if (diff < smallest_diff) {
-        smallest_diff = diff;
-        best_block = current;
-        if (diff == 0)
-          return current;
-      }
-    }
+void MemoryManager::configure_vm_disk(size_t channels, size_t queue_depth) {
+  vm_system.configure_disk(channels, queue_depth);
+}
 
-    current = current->next;
-  }
+void MemoryManager::set_vm_cpu_time(size_t us) { vm_system.set_cpu_time(us); }
 
-  return best_block;
+void MemoryManager::configure_tlb(int level, size_t entries, size_t ways,
+                                  CacheReplacementPolicy policy) {
+  vm_system.configure_tlb(level, entries, ways, policy);
 }
 
-BlockHeader *MemoryManager::find_worst_fit(size_t size) {
-  BlockHeader *current = head;
-  BlockHeader *worst_block = nullptr;
-  size_t largest_size = 0;
+void MemoryManager::set_tlb_walk_latency(size_t cycles) {
+  vm_system.set_walk_latency(cycles);
+}
 
-  while (current != nullptr) {
+size_t MemoryManager::get_block_offset(BlockHeader *block) {
+  return static_cast<size_t>(reinterpret_cast<char *>(block) - memory.data());
+}
 
-    if (current->is_free && current->size >= size) {
+void MemoryManager::index_free_block(BlockHeader *block) {
+  free_index.insert(get_block_offset(block), block->size());
+}
 
-      if (current->size > largest_size) {
-        largest_size = current->size;
-        worst_block = current;
-      }
-    }
+void MemoryManager::unindex_free_block(BlockHeader *block) {
+  free_index.erase(get_block_offset(block), block->size());
+}
 
-    current = current->next;
-  }
+BlockHeader *MemoryManager::next_block(BlockHeader *block) {
+  size_t next = get_block_offset(block) + sizeof(BlockHeader) + block->size();
+  if (next + sizeof(BlockHeader) > total_size)
+    return nullptr;
+  return reinterpret_cast<BlockHeader *>(memory.data() + next);
+}
 
-  return worst_block;
+BlockHeader *MemoryManager::prev_free_block(BlockHeader *block) {
+  if (!block->prev_free())
+    return nullptr;
+  BlockFooter *footer = reinterpret_cast<BlockFooter *>(block) - 1;
+  return reinterpret_cast<BlockHeader *>(reinterpret_cast<char *>(block) -
+                                         footer->size - sizeof(BlockHeader));
 }
 
-void MemoryManager::print_stats() {
-  BlockHeader *current = head;
-  size_t total_free_mem = 0;
-  size_t total_used_mem = 0;
-  size_t total_internal_frag = 0;
-  size_t largest_free_block = 0;
+// Sets the free bit and keeps the boundary tags consistent: free blocks get a
+// footer, and the next block's PREV_FREE bit mirrors this block's state.
+void MemoryManager::mark_block(BlockHeader *block, bool is_free) {
+  block->set_flag(BLOCK_FREE, is_free);
+
+  if (is_free) {
+    BlockFooter *footer = reinterpret_cast<BlockFooter *>(
+                              reinterpret_cast<char *>(block + 1) +
+                              block->size()) -
+                          1;
+    footer->size = static_cast<uint32_t>(block->size());
+  }
 
-  while (current != nullptr) {
+  BlockHeader *next = next_block(block);
+  if (next)
+    next->set_flag(BLOCK_PREV_FREE, is_free);
+}
 
-    if (current->is_free) {
-      total_free_mem += current->size;
+BlockHeader *MemoryManager::find_first_fit(size_t size) {
+  size_t offset = free_index.find_first_fit(size);
+  if (offset == FreeBlockIndex::NPOS)
+    return nullptr;
+  return reinterpret_cast<BlockHeader *>(memory.data() + offset);
+}
 
-      if (current->size > largest_free_block) {
-        largest_free_block = current->size;
-      }
+BlockHeader *MemoryManager::find_best_fit(size_t size) {
+  size_t offset = free_index.find_best_fit(size);
+  if (offset == FreeBlockIndex::NPOS)
+    return nullptr;
+  return reinterpret_cast<BlockHeader *>(memory.data() + offset);
+}
 
-    } else {
-      total_used_mem += current->size;
-      total_internal_frag += current->padding;
-    }
+BlockHeader *MemoryManager::find_worst_fit(size_t size) {
+  size_t offset = free_index.find_worst_fit(size);
+  if (offset == FreeBlockIndex::NPOS)
+    return nullptr;
+  return reinterpret_cast<BlockHeader *>(memory.data() + offset);
+}
 
-    current = current->next;
+// The free-list, buddy and TLSF figures are maintained online, so a stats
+// sample costs O(1) (plus the histogram) instead of a walk over every block.
+void MemoryManager::print_stats() {
+  size_t total_free_mem = free_index.total_bytes();
+  size_t total_used_mem = used_bytes;
+  size_t total_internal_frag = internal_frag_bytes;
+  size_t largest_free_block = free_index.largest();
+
+  if (current_strategy == AllocationStrategy::TLSF) {
+    tlsf_system.collect_stats(total_used_mem, total_free_mem,
+                              total_internal_frag, largest_free_block);
+  } else if (current_strategy == AllocationStrategy::CONCURRENT) {
+    concurrent_system.collect_stats(total_used_mem, total_free_mem,
+                                    total_internal_frag, largest_free_block);
+  } else if (current_strategy == AllocationStrategy::BUDDY) {
+    buddy_system.collect_stats(total_used_mem, total_free_mem,
+                               total_internal_frag, largest_free_block);
   }
 
   std::cout << "\n=== Memory System Statistics ===" << std::endl;
@@ -143,6 +247,8 @@ void MemoryManager::print_stats() {
 
   std::cout << "External Fragmentation: " << (ext_frag * 100.0) << "%"
             << std::endl;
+  std::cout << "Largest Free Block: " << largest_free_block << " bytes"
+            << std::endl;
   std::cout << "Allocation Requests: " << total_alloc_requests << std::endl;
   std::cout << "Successful Allocs:   " << successful_allocs << std::endl;
   double success_rate =
@@ -151,40 +257,63 @@ void MemoryManager::print_stats() {
                 100.0
           : 0.0;
   std::cout << "Success Rate:        " << success_rate << "%" << std::endl;
+
+  if (reallocs_in_place + reallocs_moved > 0) {
+    std::cout << "Reallocs:            " << reallocs_in_place << " in place, "
+              << reallocs_moved << " moved" << std::endl;
+  }
+
+  if (compactions > 0) {
+    std::cout << "Compactions:         " << compactions << " ("
+              << compaction_bytes_moved << " bytes moved, "
+              << compaction_time_us << " us)" << std::endl;
+  }
   std::cout << "==============================\n" << std::endl;
+
+  if (uses_free_list() || current_strategy == AllocationStrategy::SLAB) {
+    free_index.print_histogram();
+  } else if (current_strategy == AllocationStrategy::BUDDY) {
+    buddy_system.print_order_stats();
+  }
+
+  if (current_strategy == AllocationStrategy::SLAB) {
+    slab_system.print_stats();
+  }
+
+  if (current_strategy == AllocationStrategy::CONCURRENT) {
+    concurrent_system.print_stats(main_thread_cache);
+  }
+
   cache_system.print_stats();
+  multicore.print_stats();
 
   if (use_virtual_memory) {
     vm_system.print_stats();
   }
 }
 
+// Lowest positive ID not held by a live block: freed IDs wait in a min-heap,
+// otherwise the next never-used ID is handed out.
 int MemoryManager::get_next_available_id() {
-  std::vector<int> used_ids;
-  BlockHeader *current = head;
-
-  while (current != nullptr) {
-
-    if (!current->is_free && current->id > 0) {
-      used_ids.push_back(current->id);
-    }
-
-    current = current->next;
+  if (!released_ids.empty()) {
+    int id = released_ids.top();
+    released_ids.pop();
+    return id;
   }
 
-  std::sort(used_ids.begin(), used_ids.end());
-  int candidate = 1;
-
-  for (int id : used_ids) {
+  return next_alloc_id++;
+}
 
-    if (id == candidate) {
-      candidate++;
-    } else if (id > candidate) {
-      return candidate;
-    }
-  }
+void MemoryManager::release_id(int id) {
+  if (id > 0)
+    released_ids.push(id);
+}
 
-  return candidate;
+BlockHeader *MemoryManager::find_block(void *ptr) {
+  auto it = blocks_by_offset.find(get_offset_from_ptr(ptr));
+  if (it == blocks_by_offset.end())
+    return nullptr;
+  return it->second;
 }
 
 void MemoryManager::init(size_t size) {
@@ -193,31 +322,80 @@ void MemoryManager::init(size_t size) {
   this->total_alloc_requests = 0;
   this->successful_allocs = 0;
   this->successful_allocs = 0;
+  compactions = 0;
+  used_bytes = 0;
+  internal_frag_bytes = 0;
+  compaction_slack.clear();
+  reallocs_in_place = 0;
+  reallocs_moved = 0;
+  compaction_bytes_moved = 0;
+  compaction_time_us = 0.0;
+  released_ids = {};
+  slab_system.reset();
+  blocks_by_offset.clear();
+  blocks_by_id.clear();
   memory.resize(size);
 
   if (current_strategy == AllocationStrategy::BUDDY) {
     buddy_system.init(memory.data(), size);
     head = nullptr;
-    cache_system.init(64, 8, 1, 256, 8, 2, 1024, 64, 8);
+    free_index.clear();
+    init_cache();
+    return;
+  }
+
+  if (current_strategy == AllocationStrategy::CONCURRENT) {
+    main_thread_cache = ConcurrentAllocator::ThreadCache();
+    concurrent_system.init(memory.data(), size, concurrent_arenas);
+    head = nullptr;
+    free_index.clear();
+    init_cache();
+    return;
+  }
+
+  if (current_strategy == AllocationStrategy::TLSF) {
+    tlsf_system.init(memory.data(), size);
+    head = nullptr;
+    free_index.clear();
+    init_cache();
+    return;
+  }
+
+  if (size < sizeof(BlockHeader) + MIN_BLOCK_PAYLOAD) {
+    std::cout << "Error: Memory too small for a single block." << std::endl;
+    head = nullptr;
+    free_index.clear();
     return;
   }
 
+  // A block's size has to fit the 32-bit header word, so the list heap
+  // stops there; block walks and bounds checks then agree on its end.
+  if (size > UINT32_MAX) {
+    std::cout << "Warning: Heap limited to " << UINT32_MAX
+              << " bytes by the 32-bit block size field." << std::endl;
+    total_size = UINT32_MAX;
+    memory.resize(total_size);
+  }
+
   head = reinterpret_cast<BlockHeader *>(memory.data());
-  head->size = size - sizeof(BlockHeader);
-  head->is_free = true;
-  head->next = nullptr;
-  head->prev = nullptr;
+  head->size_flags = 0;
+  head->set_size((total_size - sizeof(BlockHeader)) & ~(size_t)7);
   head->padding = 0;
-  std::cout << "Memory initialized with " << size << " bytes." << std::endl;
-  std::cout << "Initial Free Block Size: " << head->size << " bytes."
+  head->id = 0;
+  mark_block(head, true);
+  free_index.clear();
+  index_free_block(head);
+  blocks_by_offset[sizeof(BlockHeader)] = head;
+  std::cout << "Memory initialized with " << total_size << " bytes."
+            << std::endl;
+  std::cout << "Initial Free Block Size: " << head->size() << " bytes."
             << std::endl;
-  cache_system.init(64, 8, 1, 256, 8, 2, 1024, 64, 8);
+  init_cache();
 }
 
-void MemoryManager::enable_vm(size_t page_size) {
+void MemoryManager::enable_vm(size_t page_size, int address_bits) {
   use_virtual_memory = true;
-  size_t virtual_size = 65536;
-  vm_system.init(page_size, virtual_size, total_size);
+  vm_system.init(page_size, address_bits, total_size);
   std::cout << "Virtual Memory Enabled." << std::endl;
 }
 
@@ -226,7 +404,7 @@ void MemoryManager::access(size_t address, char rw) {
 
   if (use_virtual_memory) {
     size_t p_addr;
-    bool result = vm_system.translate(address, p_addr);
+    bool result = vm_system.translate(address, p_addr, rw == 'W');
 
     if (result) {
       std::cout << "  Virtual Address " << address << " -> Physical Address "
@@ -243,9 +421,101 @@ void MemoryManager::access(size_t address, char rw) {
     return;
   }
 
+  if (mrc_analyzer.is_enabled())
+    mrc_analyzer.record(final_addr);
+  if (opt_analyzer.is_enabled())
+    opt_analyzer.record(address, final_addr);
   cache_system.access(final_addr, rw);
 }
 
+void MemoryManager::start_mrc(size_t block_size, double sampling_rate,
+                              size_t max_samples) {
+  mrc_analyzer.start(block_size, sampling_rate, max_samples);
+  std::cout << "Recording stack distances (" << block_size << "B blocks";
+  if (sampling_rate < 1)
+    std::cout << ", sampling rate " << sampling_rate;
+  if (max_samples > 0)
+    std::cout << ", at most " << max_samples << " sampled lines";
+  std::cout << ")." << std::endl;
+}
+
+void MemoryManager::analyze_trace_file(const std::string &path,
+                                       size_t block_size, double sampling_rate,
+                                       size_t max_samples) {
+  bool was_enabled = mrc_analyzer.is_enabled();
+  mrc_analyzer.start(block_size, sampling_rate, max_samples);
+
+  if (mrc_analyzer.analyze_file(path))
+    mrc_analyzer.print_curve();
+  if (!was_enabled)
+    mrc_analyzer.stop();
+}
+
+void MemoryManager::start_opt() {
+  opt_analyzer.start();
+  std::cout << "Recording references for the OPT bound." << std::endl;
+}
+
+// Bounds the current configuration: the VM frames when VM is enabled and
+// every cache level, each against the policies it could be switched to.
+void MemoryManager::print_opt() {
+  std::cout << "\n=== Belady OPT Bound (" << opt_analyzer.size()
+            << " references) ===" << std::endl;
+
+  if (opt_analyzer.size() == 0) {
+    std::cout << "No references recorded." << std::endl;
+    return;
+  }
+
+  if (use_virtual_memory)
+    opt_analyzer.report_frames(vm_system.get_page_size(),
+                               vm_system.get_total_frames());
+
+  for (int i = 0; i < 3; ++i) {
+    const CacheLevel *level = cache_system.get_level(i);
+    opt_analyzer.report_cache(i + 1, level->get_capacity(),
+                              level->get_block_size(),
+                              level->get_associativity());
+  }
+}
+
+void MemoryManager::analyze_opt_file(const std::string &path) {
+  bool was_enabled = opt_analyzer.is_enabled();
+  opt_analyzer.start();
+
+  if (opt_analyzer.load_file(path))
+    print_opt();
+  if (!was_enabled)
+    opt_analyzer.stop();
+}
+
+void MemoryManager::init_multicore(int cores, CoherenceProtocol protocol,
+                                   size_t l1_size, size_t l2_size,
+                                   size_t l3_size, size_t block_size) {
+  multicore.init(cores, protocol, l1_size, l2_size, l3_size, block_size);
+}
+
+// Multi-core references use raw addresses; they model other threads'
+// working sets and do not go through the heap or virtual memory.
+bool MemoryManager::multicore_access(int core, size_t address, char rw) {
+  if (!multicore.is_enabled() || core < 0 || core >= multicore.core_count())
+    return false;
+  multicore.access(core, address, rw == 'W' || rw == 'w');
+  return true;
+}
+
+void MemoryManager::run_multicore(const std::vector<std::string> &paths,
+                                  bool parallel) {
+  if (!multicore.is_enabled()) {
+    std::cout << "Error: Multi-core mode not initialized. Run 'multicore init' "
+                 "first."
+              << std::endl;
+    return;
+  }
+
+  multicore.run_traces(paths, parallel);
+}
+
 void MemoryManager::dump_memory() {
 
   if (current_strategy == AllocationStrategy::BUDDY) {
@@ -253,44 +523,56 @@ void MemoryManager::dump_memory() {
     return;
   }
 
+  if (current_strategy == AllocationStrategy::TLSF) {
+    tlsf_system.debug_lists();
+    return;
+  }
+
+  if (current_strategy == AllocationStrategy::CONCURRENT) {
+    concurrent_system.debug_lists();
+    return;
+  }
+
   std::cout << "\n--- Memory dump ---" << std::endl;
   BlockHeader *current = head;
   size_t offset = 0;
 
   while (current != nullptr) {
     std::cout << "[" << offset << " - "
-              << (offset + sizeof(BlockHeader) + current->size - 1) << "] ";
+              << (offset + sizeof(BlockHeader) + current->size() - 1) << "] ";
 
-    if (current->is_free) {
+    size_t class_size;
+    int used, capacity;
+
+    if (current->is_free()) {
       std::cout << "FREE";
+    } else if (current->id == 0 &&
+               slab_system.describe_page(current + 1, class_size, used,
+                                         capacity)) {
+      std::cout << "SLAB (Class " << class_size << ", " << used << "/"
+                << capacity << " used)";
     } else {
       std::cout << "USED (ID=" << current->id << ")";
     }
 
-    std::cout << " | Size: " << current->size << " (+32 header)" << std::endl;
-    offset += sizeof(BlockHeader) + current->size;
-    current = current->next;
+    std::cout << " | Size: " << current->size() << " (+" << sizeof(BlockHeader)
+              << " header)" << std::endl;
+    offset += sizeof(BlockHeader) + current->size();
+    current = next_block(current);
   }
 
   std::cout << "-------------------\n" << std::endl;
 }
 
-void *MemoryManager::malloc(size_t size) {
-  total_alloc_requests++;
-
-  if (current_strategy == AllocationStrategy::BUDDY) {
-    void *ptr = buddy_system.malloc(size);
-    if (ptr)
-      successful_allocs++;
-    return ptr;
-  }
-
-  size_t aligned_size = align(size);
-  size_t padding = aligned_size - size;
+// Takes a free block for the strategy, splits off the tail when it is big
+// enough to stand alone, and marks the block used. IDs are left to callers.
+BlockHeader *MemoryManager::allocate_block(size_t aligned_size,
+                                           AllocationStrategy strategy) {
   BlockHeader *candidate = nullptr;
 
-  switch (current_strategy) {
+  switch (strategy) {
   case AllocationStrategy::FIRST_FIT:
+  case AllocationStrategy::SLAB:
     candidate = find_first_fit(aligned_size);
     break;
   case AllocationStrategy::BEST_FIT:
@@ -307,25 +589,171 @@ void *MemoryManager::malloc(size_t size) {
     return nullptr;
   }
 
-  if (candidate->size >= aligned_size + sizeof(BlockHeader) + 1) {
-    BlockHeader *new_block =
-        reinterpret_cast<BlockHeader *>(reinterpret_cast<char *>(candidate) +
-                                        sizeof(BlockHeader) + aligned_size);
-    new_block->size = candidate->size - aligned_size - sizeof(BlockHeader);
-    new_block->is_free = true;
-    new_block->next = candidate->next;
-    new_block->prev = candidate;
-    new_block->id = 0;
-    new_block->padding = 0;
-    candidate->size = aligned_size;
-    candidate->next = new_block;
-    if (new_block->next)
-      new_block->next->prev = new_block;
+  unindex_free_block(candidate);
+  split_block(candidate, aligned_size);
+  mark_block(candidate, false);
+  candidate->padding = 0;
+  used_bytes += candidate->size();
+  return candidate;
+}
+
+// Trims the block to aligned_size when the tail is big enough to stand on
+// its own; the tail is released and so merges with a free successor.
+void MemoryManager::split_block(BlockHeader *block, size_t aligned_size) {
+  if (block->size() < aligned_size + sizeof(BlockHeader) + MIN_BLOCK_PAYLOAD)
+    return;
+  BlockHeader *rest =
+      reinterpret_cast<BlockHeader *>(reinterpret_cast<char *>(block) +
+                                      sizeof(BlockHeader) + aligned_size);
+  rest->size_flags = 0;
+  rest->set_size(block->size() - aligned_size - sizeof(BlockHeader));
+  rest->id = 0;
+  rest->padding = 0;
+  rest->set_flag(BLOCK_FREE, true);
+  if (!block->is_free())
+    used_bytes -= block->size() - aligned_size;
+  block->set_size(aligned_size);
+  blocks_by_offset[get_offset_from_ptr(rest + 1)] = rest;
+  release_block(rest);
+}
+
+// Every resize and free resets the padding, so this is also where a block
+// gives up any compaction slack it was carrying.
+void MemoryManager::set_padding(BlockHeader *block, size_t padding) {
+  internal_frag_bytes += padding;
+  internal_frag_bytes -= block->padding;
+  block->padding = padding;
+
+  auto slack = compaction_slack.find(block->id);
+  if (slack != compaction_slack.end()) {
+    internal_frag_bytes -= slack->second;
+    compaction_slack.erase(slack);
+  }
+}
+
+bool MemoryManager::grow_in_place(BlockHeader *block, size_t aligned_size) {
+  BlockHeader *next = next_block(block);
+  if (!next || !next->is_free() ||
+      block->size() + sizeof(BlockHeader) + next->size() < aligned_size)
+    return false;
+  unindex_free_block(next);
+  blocks_by_offset.erase(get_offset_from_ptr(next + 1));
+  used_bytes += sizeof(BlockHeader) + next->size();
+  block->set_size(block->size() + sizeof(BlockHeader) + next->size());
+  mark_block(block, false);
+  split_block(block, aligned_size);
+  return true;
+}
+
+// Used blocks leave the online counters here; split_block marks its tail
+// free beforehand so that a fresh tail is not subtracted.
+void MemoryManager::release_block(BlockHeader *block) {
+  if (!block->is_free()) {
+    used_bytes -= block->size();
+    set_padding(block, 0);
+  }
+
+  block->id = 0;
+  BlockHeader *next = next_block(block);
+
+  if (next && next->is_free()) {
+    unindex_free_block(next);
+    blocks_by_offset.erase(get_offset_from_ptr(next + 1));
+    block->set_size(block->size() + sizeof(BlockHeader) + next->size());
+  }
+
+  BlockHeader *prev = prev_free_block(block);
+
+  if (prev) {
+    unindex_free_block(prev);
+    blocks_by_offset.erase(get_offset_from_ptr(block + 1));
+    prev->set_size(prev->size() + sizeof(BlockHeader) + block->size());
+    block = prev;
+  }
+
+  mark_block(block, true);
+  index_free_block(block);
+}
+
+void *MemoryManager::slab_malloc(size_t size) {
+  void *ptr = slab_system.malloc(size);
+  if (ptr)
+    return ptr;
+  BlockHeader *page =
+      allocate_block(SlabAllocator::PAGE_SIZE, AllocationStrategy::FIRST_FIT);
+
+  if (page == nullptr) {
+    std::cout << "Slab Allocator: No memory available." << std::endl;
+    return nullptr;
+  }
+
+  page->id = 0;
+  page->padding = 0;
+  slab_system.add_page(reinterpret_cast<char *>(page + 1),
+                       slab_system.get_class(size));
+  std::cout << "Slab Page allocated at address " << get_offset_from_ptr(page + 1)
+            << std::endl;
+  return slab_system.malloc(size);
+}
+
+void *MemoryManager::malloc(size_t size) {
+  total_alloc_requests++;
+
+  if (current_strategy == AllocationStrategy::BUDDY) {
+    void *ptr = buddy_system.malloc(size);
+    if (ptr)
+      successful_allocs++;
+    return ptr;
+  }
+
+  if (current_strategy == AllocationStrategy::TLSF) {
+    void *ptr = tlsf_system.malloc(size);
+    if (ptr)
+      successful_allocs++;
+    return ptr;
+  }
+
+  if (current_strategy == AllocationStrategy::CONCURRENT) {
+    void *ptr = concurrent_system.malloc(main_thread_cache, size);
+    if (ptr)
+      successful_allocs++;
+    return ptr;
+  }
+
+  if (current_strategy == AllocationStrategy::SLAB &&
+      size <= SlabAllocator::MAX_OBJECT_SIZE) {
+    void *ptr = slab_malloc(size);
+    if (ptr)
+      successful_allocs++;
+    return ptr;
+  }
+
+  size_t aligned_size = align(size);
+  size_t padding = aligned_size - size;
+  if (aligned_size < MIN_BLOCK_PAYLOAD)
+    aligned_size = MIN_BLOCK_PAYLOAD;
+  BlockHeader *candidate = allocate_block(aligned_size, current_strategy);
+
+  if (candidate == nullptr && auto_compact && free_index.count() > 1 &&
+      free_index.total_bytes() +
+              (free_index.count() - 1) * sizeof(BlockHeader) >=
+          aligned_size) {
+    std::cout << "Allocation of " << size
+              << " bytes failed due to fragmentation. Compacting..."
+              << std::endl;
+
+    if (compact()) {
+      candidate = allocate_block(aligned_size, current_strategy);
+    }
+  }
+
+  if (candidate == nullptr) {
+    return nullptr;
   }
 
-  candidate->is_free = false;
   candidate->id = get_next_available_id();
-  candidate->padding = padding;
+  set_padding(candidate, padding);
+  blocks_by_id[candidate->id] = candidate;
   successful_allocs++;
   std::cout << "Allocated block id " << candidate->id << " at address "
             << get_offset_from_ptr(reinterpret_cast<char *>(candidate) +
@@ -343,63 +771,54 @@ void MemoryManager::free(void *ptr) {
     return;
   }
 
-  BlockHeader *current = head;
-  bool found = false;
+  if (current_strategy == AllocationStrategy::TLSF) {
+    tlsf_system.free(ptr);
+    return;
+  }
 
-  while (current != nullptr) {
-    void *data_ptr = reinterpret_cast<char *>(current) + sizeof(BlockHeader);
+  if (current_strategy == AllocationStrategy::CONCURRENT) {
+    concurrent_system.free(main_thread_cache, ptr);
+    return;
+  }
 
-    if (data_ptr == ptr) {
-      found = true;
-      break;
+  if (current_strategy == AllocationStrategy::SLAB && slab_system.owns(ptr)) {
+    char *empty_page = slab_system.free(ptr);
+
+    if (empty_page) {
+      std::cout << "Slab Page released at address "
+                << get_offset_from_ptr(empty_page) << std::endl;
+      release_block(find_block(empty_page));
     }
 
-    current = current->next;
+    return;
   }
 
-  if (!found) {
+  BlockHeader *current = find_block(ptr);
+
+  if (current == nullptr || (!current->is_free() && current->id == 0)) {
     std::cout << "Error: Invalid address. Pointer is not the start of an "
                  "allocated block."
               << std::endl;
     return;
   }
 
-  if (current->is_free) {
+  if (current->is_free()) {
     std::cout << "Error: Block is already free." << std::endl;
     return;
   }
 
   std::cout << "Freeing Block ID " << current->id << "..." << std::endl;
-  current->is_free = true;
-  current->id = 0;
-
-  if (current->next && current->next->is_free) {
-    current->size += sizeof(BlockHeader) + current->next->size;
-    current->next = current->next->next;
-    if (current->next)
-      current->next->prev = current;
-  }
-
-  if (current->prev && current->prev->is_free) {
-    current->prev->size += sizeof(BlockHeader) + current->size;
-    current->prev->next = current->next;
-    if (current->next)
-      current->next->prev = current->prev;
-  }
+  blocks_by_id.erase(current->id);
+  release_id(current->id);
+  release_block(current);
 }
 
 void MemoryManager::free_by_id(int id) {
-  BlockHeader *current = head;
+  auto it = blocks_by_id.find(id);
 
-  while (current != nullptr) {
-
-    if (!current->is_free && current->id == id) {
-      void *ptr = reinterpret_cast<char *>(current) + sizeof(BlockHeader);
-      free(ptr);
-      return;
-    }
-
-    current = current->next;
+  if (it != blocks_by_id.end()) {
+    free(reinterpret_cast<char *>(it->second) + sizeof(BlockHeader));
+    return;
   }
 
   std::cout << "Error: Block ID " << id << " not found or already freed."
@@ -407,48 +826,294 @@ void MemoryManager::free_by_id(int id) {
 }
 
 void MemoryManager::free_smart(int value) {
-  BlockHeader *current = head;
   BlockHeader *target = nullptr;
 
-  while (current != nullptr) {
+  if (current_strategy == AllocationStrategy::BUDDY ||
+      current_strategy == AllocationStrategy::TLSF ||
+      current_strategy == AllocationStrategy::CONCURRENT) {
+    void *ptr = get_ptr_from_offset(static_cast<size_t>(value));
+    bool owned = false;
+
+    if (ptr && current_strategy == AllocationStrategy::BUDDY) {
+      owned = buddy_system.owns(ptr);
+    } else if (ptr && current_strategy == AllocationStrategy::TLSF) {
+      owned = tlsf_system.owns(ptr);
+    } else if (ptr) {
+      owned = concurrent_system.owns(main_thread_cache, ptr);
+    }
 
-    if (!current->is_free && current->id == value) {
-      target = current;
-      break;
+    if (owned) {
+      free(ptr);
+    } else {
+      std::cout << "Error: No allocated block found at Address " << value
+                << std::endl;
     }
 
-    current = current->next;
+    return;
   }
 
-  if (target == nullptr) {
+  auto it = blocks_by_id.find(value);
+
+  if (it != blocks_by_id.end()) {
+    target = it->second;
+  } else {
     void *ptr = get_ptr_from_offset(static_cast<size_t>(value));
 
+    if (ptr && current_strategy == AllocationStrategy::SLAB &&
+        slab_system.owns(ptr)) {
+      free(ptr);
+      return;
+    }
+
     if (ptr) {
-      current = head;
+      BlockHeader *block = find_block(ptr);
 
-      while (current != nullptr) {
-        void *data_loc =
-            reinterpret_cast<char *>(current) + sizeof(BlockHeader);
+      if (block && !block->is_free() && block->id != 0) {
+        target = block;
+      }
+    }
+  }
+
+  if (target != nullptr) {
+    void *ptr = reinterpret_cast<char *>(target) + sizeof(BlockHeader);
+    free(ptr);
+  } else {
+    std::cout << "Error: No allocated block found with ID or Address " << value
+              << std::endl;
+  }
+}
 
-        if (data_loc == ptr) {
+bool MemoryManager::uses_free_list() const {
+  return current_strategy == AllocationStrategy::FIRST_FIT ||
+         current_strategy == AllocationStrategy::BEST_FIT ||
+         current_strategy == AllocationStrategy::WORST_FIT;
+}
 
-          if (!current->is_free) {
-            target = current;
-          }
+// Slides every live block down over the gaps in front of it and leaves one
+// free block at the top of the heap. Block IDs are the handles: the ID map is
+// the indirection table and is repointed as blocks move, so 'handle <id>'
+// keeps resolving after a compaction while raw addresses do not.
+bool MemoryManager::compact() {
+  if (!uses_free_list() || head == nullptr) {
+    std::cout << "Error: Compaction is only supported for first, best and "
+                 "worst fit."
+              << std::endl;
+    return false;
+  }
 
-          break;
-        }
+  if (!slab_system.empty()) {
+    std::cout << "Error: Cannot compact while slab pages are live."
+              << std::endl;
+    return false;
+  }
 
-        current = current->next;
+  auto start = std::chrono::steady_clock::now();
+  char *base = memory.data();
+  size_t offset = 0;
+  size_t cursor = 0;
+  size_t heap_end = 0;
+  size_t bytes_moved = 0;
+  size_t blocks_moved = 0;
+  BlockHeader *last_used = nullptr;
+  blocks_by_offset.clear();
+  free_index.clear();
+
+  while (true) {
+    BlockHeader *block = reinterpret_cast<BlockHeader *>(base + offset);
+    size_t block_bytes = sizeof(BlockHeader) + block->size();
+    bool is_last = next_block(block) == nullptr;
+    heap_end = offset + block_bytes;
+
+    if (!block->is_free()) {
+
+      if (offset != cursor) {
+        std::memmove(base + cursor, base + offset, block_bytes);
+        bytes_moved += block_bytes;
+        blocks_moved++;
       }
+
+      BlockHeader *moved = reinterpret_cast<BlockHeader *>(base + cursor);
+      moved->set_flag(BLOCK_PREV_FREE, false);
+      blocks_by_offset[cursor + sizeof(BlockHeader)] = moved;
+      if (moved->id != 0)
+        blocks_by_id[moved->id] = moved;
+      last_used = moved;
+      cursor += block_bytes;
     }
+
+    if (is_last)
+      break;
+    offset += block_bytes;
   }
 
-  if (target != nullptr) {
-    void *ptr = reinterpret_cast<char *>(target) + sizeof(BlockHeader);
+  size_t remaining = heap_end - cursor;
+
+  if (remaining >= sizeof(BlockHeader) + MIN_BLOCK_PAYLOAD || !last_used) {
+    BlockHeader *tail = reinterpret_cast<BlockHeader *>(base + cursor);
+    tail->size_flags = 0;
+    tail->set_size(remaining - sizeof(BlockHeader));
+    tail->id = 0;
+    tail->padding = 0;
+    mark_block(tail, true);
+    index_free_block(tail);
+    blocks_by_offset[cursor + sizeof(BlockHeader)] = tail;
+  } else if (remaining > 0) {
+    last_used->set_size(last_used->size() + remaining);
+    used_bytes += remaining;
+    internal_frag_bytes += remaining;
+    compaction_slack[last_used->id] += remaining;
+  }
+
+  double elapsed_us = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  compactions++;
+  compaction_bytes_moved += bytes_moved;
+  compaction_time_us += elapsed_us;
+  std::cout << "Compaction moved " << blocks_moved << " block(s), "
+            << bytes_moved << " bytes. Free block: "
+            << (remaining >= sizeof(BlockHeader) + MIN_BLOCK_PAYLOAD
+                    ? remaining - sizeof(BlockHeader)
+                    : 0)
+            << " bytes." << std::endl;
+  return true;
+}
+
+void MemoryManager::print_handle(int id) {
+  auto it = blocks_by_id.find(id);
+
+  if (it == blocks_by_id.end()) {
+    std::cout << "Error: Block ID " << id << " not found or already freed."
+              << std::endl;
+    return;
+  }
+
+  std::cout << "Handle " << id << " -> address "
+            << get_offset_from_ptr(it->second + 1) << " (" << it->second->size()
+            << " bytes)" << std::endl;
+}
+
+void *MemoryManager::buddy_realloc(void *ptr, size_t size) {
+  if (!buddy_system.owns(ptr)) {
+    std::cout << "Error: Invalid address. Pointer is not the start of an "
+                 "allocated block."
+              << std::endl;
+    return nullptr;
+  }
+
+  size_t old_size = buddy_system.usable_size(ptr);
+
+  if (buddy_system.resize_in_place(ptr, size)) {
+    reallocs_in_place++;
+    std::cout << "Resized block in place at address " << get_offset_from_ptr(ptr)
+              << " (" << old_size << " -> " << buddy_system.usable_size(ptr)
+              << " bytes)" << std::endl;
+    return ptr;
+  }
+
+  void *moved = buddy_system.malloc(size);
+  if (!moved)
+    return nullptr;
+  std::memcpy(moved, ptr, std::min(old_size, size));
+  buddy_system.free(ptr);
+  reallocs_moved++;
+  std::cout << "Moved block from address " << get_offset_from_ptr(ptr)
+            << " to " << get_offset_from_ptr(moved) << " (" << size
+            << " bytes)" << std::endl;
+  return moved;
+}
+
+// Shrinks by splitting, grows into a free successor, and only copies when
+// neither works. A moved block keeps its ID, so 'handle' still resolves it.
+void *MemoryManager::realloc(void *ptr, size_t size) {
+  if (!ptr)
+    return malloc(size);
+
+  if (size == 0) {
     free(ptr);
-  } else {
+    return nullptr;
+  }
+
+  if (current_strategy == AllocationStrategy::BUDDY)
+    return buddy_realloc(ptr, size);
+
+  if (current_strategy == AllocationStrategy::TLSF ||
+      current_strategy == AllocationStrategy::CONCURRENT ||
+      (current_strategy == AllocationStrategy::SLAB && slab_system.owns(ptr))) {
+    std::cout << "Error: realloc is only supported for free-list and buddy "
+                 "blocks."
+              << std::endl;
+    return nullptr;
+  }
+
+  BlockHeader *block = find_block(ptr);
+
+  if (block == nullptr || block->is_free() || block->id == 0) {
+    std::cout << "Error: Invalid address. Pointer is not the start of an "
+                 "allocated block."
+              << std::endl;
+    return nullptr;
+  }
+
+  size_t aligned_size = align(size);
+  size_t padding = aligned_size - size;
+  if (aligned_size < MIN_BLOCK_PAYLOAD)
+    aligned_size = MIN_BLOCK_PAYLOAD;
+  size_t old_size = block->size();
+
+  if (aligned_size <= old_size || grow_in_place(block, aligned_size)) {
+    if (aligned_size <= old_size)
+      split_block(block, aligned_size);
+    set_padding(block, padding);
+    reallocs_in_place++;
+    std::cout << "Resized block id " << block->id << " in place at address "
+              << get_offset_from_ptr(ptr) << " (" << old_size << " -> "
+              << block->size() << " bytes)" << std::endl;
+    return ptr;
+  }
+
+  BlockHeader *moved = allocate_block(aligned_size, current_strategy);
+  if (moved == nullptr)
+    return nullptr;
+  std::memcpy(moved + 1, block + 1, old_size);
+  moved->id = block->id;
+  set_padding(moved, padding);
+  blocks_by_id[moved->id] = moved;
+  release_block(block);
+  reallocs_moved++;
+  std::cout << "Moved block id " << moved->id << " from address "
+            << get_offset_from_ptr(ptr) << " to "
+            << get_offset_from_ptr(moved + 1) << " (" << moved->size()
+            << " bytes)" << std::endl;
+  return moved + 1;
+}
+
+void *MemoryManager::realloc_smart(int value, size_t size) {
+  if (current_strategy != AllocationStrategy::BUDDY) {
+    auto it = blocks_by_id.find(value);
+    if (it != blocks_by_id.end())
+      return realloc(it->second + 1, size);
+  }
+
+  void *ptr = get_ptr_from_offset(static_cast<size_t>(value));
+
+  if (ptr == nullptr) {
     std::cout << "Error: No allocated block found with ID or Address " << value
               << std::endl;
+    return nullptr;
+  }
+
+  return realloc(ptr, size);
+}
+
+void *MemoryManager::calloc(size_t count, size_t size) {
+  if (size != 0 && count > SIZE_MAX / size) {
+    std::cout << "Error: calloc size overflows." << std::endl;
+    return nullptr;
   }
-}
\ No newline at end of file
+
+  void *ptr = malloc(count * size);
+  if (ptr)
+    std::memset(ptr, 0, count * size);
+  return ptr;
+}
@@ -0,0 +1,176 @@
+#include "../../include/slab_allocator.h"
+
+const size_t SlabAllocator::CLASS_SIZES[SlabAllocator::NUM_CLASSES] = {
+    8, 16, 32, 48, 64, 96, 128, 192, 256};
+
+void SlabAllocator::reset() {
+  pages.clear();
+
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+    partial[i].clear();
+  }
+}
+
+int SlabAllocator::get_class(size_t size) const {
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+
+    if (size <= CLASS_SIZES[i]) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+size_t SlabAllocator::get_class_size(int size_class) const {
+  return CLASS_SIZES[size_class];
+}
+
+void SlabAllocator::add_page(char *start, int size_class) {
+  SlabPage page;
+  page.size_class = size_class;
+  page.capacity = static_cast<int>(PAGE_SIZE / CLASS_SIZES[size_class]);
+  page.used = 0;
+  page.free_slots = page.capacity == 64 ? ~(uint64_t)0
+                                        : ((uint64_t)1 << page.capacity) - 1;
+  page.requested_bytes = 0;
+  pages[start] = page;
+  partial[size_class].push_back(start);
+}
+
+void *SlabAllocator::malloc(size_t size) {
+  int size_class = get_class(size);
+  if (size_class < 0 || partial[size_class].empty())
+    return nullptr;
+  char *start = partial[size_class].back();
+  SlabPage &page = pages[start];
+  int slot = __builtin_ctzll(page.free_slots);
+  page.free_slots &= ~((uint64_t)1 << slot);
+  page.used++;
+  page.requested[slot] = static_cast<uint16_t>(size);
+  page.requested_bytes += size;
+  if (page.used == page.capacity)
+    partial[size_class].pop_back();
+  std::cout << "Slab Alloc: Class " << CLASS_SIZES[size_class] << " (slot "
+            << slot << ", " << page.used << "/" << page.capacity << " used)"
+            << std::endl;
+  return start + slot * CLASS_SIZES[size_class];
+}
+
+SlabAllocator::SlabPage *SlabAllocator::find_page(void *ptr, char *&start) {
+  char *p = static_cast<char *>(ptr);
+  auto it = pages.upper_bound(p);
+  if (it == pages.begin())
+    return nullptr;
+  --it;
+  if (p >= it->first + PAGE_SIZE)
+    return nullptr;
+  start = it->first;
+  return &it->second;
+}
+
+bool SlabAllocator::owns(void *ptr) {
+  char *start;
+  SlabPage *page = find_page(ptr, start);
+  if (!page)
+    return false;
+  size_t class_size = CLASS_SIZES[page->size_class];
+  size_t delta = static_cast<size_t>(static_cast<char *>(ptr) - start);
+  if (delta % class_size != 0 || delta / class_size >= (size_t)page->capacity)
+    return false;
+  return !((page->free_slots >> (delta / class_size)) & 1);
+}
+
+void SlabAllocator::remove_partial(int size_class, char *start) {
+  std::vector<char *> &list = partial[size_class];
+
+  for (size_t i = 0; i < list.size(); ++i) {
+
+    if (list[i] == start) {
+      list[i] = list.back();
+      list.pop_back();
+      return;
+    }
+  }
+}
+
+// Returns the page start when the page has become empty so the caller can
+// hand it back to the heap; nullptr otherwise.
+char *SlabAllocator::free(void *ptr) {
+  if (!owns(ptr))
+    return nullptr;
+  char *start;
+  SlabPage *page = find_page(ptr, start);
+  size_t class_size = CLASS_SIZES[page->size_class];
+  int slot = static_cast<int>((static_cast<char *>(ptr) - start) / class_size);
+  if (page->used == page->capacity)
+    partial[page->size_class].push_back(start);
+  page->free_slots |= (uint64_t)1 << slot;
+  page->used--;
+  page->requested_bytes -= page->requested[slot];
+  std::cout << "Slab Free: Class " << class_size << " (slot " << slot << ", "
+            << page->used << "/" << page->capacity << " used)" << std::endl;
+
+  if (page->used == 0) {
+    remove_partial(page->size_class, start);
+    pages.erase(start);
+    return start;
+  }
+
+  return nullptr;
+}
+
+bool SlabAllocator::describe_page(void *start, size_t &class_size, int &used,
+                                  int &capacity) {
+  auto it = pages.find(static_cast<char *>(start));
+  if (it == pages.end())
+    return false;
+  class_size = CLASS_SIZES[it->second.size_class];
+  used = it->second.used;
+  capacity = it->second.capacity;
+  return true;
+}
+
+void SlabAllocator::print_stats() {
+  size_t class_pages[NUM_CLASSES] = {0};
+  size_t class_used[NUM_CLASSES] = {0};
+  size_t class_capacity[NUM_CLASSES] = {0};
+  size_t class_waste[NUM_CLASSES] = {0};
+
+  for (const auto &entry : pages) {
+    const SlabPage &page = entry.second;
+    class_pages[page.size_class]++;
+    class_used[page.size_class] += page.used;
+    class_capacity[page.size_class] += page.capacity;
+    class_waste[page.size_class] += PAGE_SIZE - page.requested_bytes;
+  }
+
+  std::cout << "=== Slab Statistics ===" << std::endl;
+  size_t total_used = 0;
+  size_t total_capacity = 0;
+  size_t total_waste = 0;
+
+  for (int i = 0; i < NUM_CLASSES; ++i) {
+    if (class_pages[i] == 0)
+      continue;
+    double occupancy =
+        static_cast<double>(class_used[i]) / class_capacity[i] * 100.0;
+    std::cout << "  Class " << CLASS_SIZES[i] << ": " << class_pages[i]
+              << " page(s), " << class_used[i] << "/" << class_capacity[i]
+              << " objects (" << occupancy << "%), waste " << class_waste[i]
+              << " bytes" << std::endl;
+    total_used += class_used[i];
+    total_capacity += class_capacity[i];
+    total_waste += class_waste[i];
+  }
+
+  double occupancy =
+      (total_capacity > 0)
+          ? static_cast<double>(total_used) / total_capacity * 100.0
+          : 0.0;
+  std::cout << "  Slab Pages: " << pages.size() << " x " << PAGE_SIZE
+            << " bytes" << std::endl;
+  std::cout << "  Slab Occupancy: " << occupancy << "%" << std::endl;
+  std::cout << "  Slab Waste: " << total_waste << " bytes" << std::endl;
+  std::cout << "=======================\n" << std::endl;
+}
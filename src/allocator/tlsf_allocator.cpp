@@ -0,0 +1,304 @@
+#include "../../include/tlsf_allocator.h"
+
+static int tlsf_ffs(uint32_t word) { return __builtin_ctz(word); }
+
+static int tlsf_fls(size_t word) { return 63 - __builtin_clzll(word); }
+
+TLSFAllocator::TLSFAllocator()
+    : memory_start(nullptr), total_size(0), fl_bitmap(0) {
+
+  for (int i = 0; i < FL_INDEX_COUNT; ++i) {
+    sl_bitmap[i] = 0;
+
+    for (int j = 0; j < SL_INDEX_COUNT; ++j) {
+      blocks[i][j] = NIL;
+    }
+  }
+}
+
+TLSFBlock *TLSFAllocator::block_at(uint32_t offset) {
+  return reinterpret_cast<TLSFBlock *>(memory_start + offset);
+}
+
+uint32_t TLSFAllocator::offset_of(TLSFBlock *block) {
+  return static_cast<uint32_t>(reinterpret_cast<char *>(block) - memory_start);
+}
+
+size_t TLSFAllocator::block_size(TLSFBlock *block) {
+  return block->size_flags & ~FREE_BIT;
+}
+
+bool TLSFAllocator::block_free(TLSFBlock *block) {
+  return block->size_flags & FREE_BIT;
+}
+
+TLSFBlock *TLSFAllocator::next_phys(TLSFBlock *block) {
+  size_t next = offset_of(block) + sizeof(TLSFBlock) + block_size(block);
+  if (next + sizeof(TLSFBlock) > total_size)
+    return nullptr;
+  return block_at(static_cast<uint32_t>(next));
+}
+
+uint32_t &TLSFAllocator::next_free(TLSFBlock *block) {
+  return reinterpret_cast<uint32_t *>(block + 1)[0];
+}
+
+uint32_t &TLSFAllocator::prev_free(TLSFBlock *block) {
+  return reinterpret_cast<uint32_t *>(block + 1)[1];
+}
+
+void TLSFAllocator::set_block(TLSFBlock *block, size_t size, bool is_free) {
+  block->size_flags = static_cast<uint32_t>(size) | (is_free ? FREE_BIT : 0);
+}
+
+void TLSFAllocator::mapping_insert(size_t size, int &fl, int &sl) {
+  if (size < SMALL_BLOCK_SIZE) {
+    fl = 0;
+    sl = static_cast<int>(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+  } else {
+    int f = tlsf_fls(size);
+    sl = static_cast<int>(size >> (f - SL_INDEX_LOG2)) ^ SL_INDEX_COUNT;
+    fl = f - (FL_INDEX_SHIFT - 1);
+  }
+}
+
+// Rounds the request up to the next list boundary so that any block found
+// in the resulting list is guaranteed to fit (good fit, not best fit).
+void TLSFAllocator::mapping_search(size_t size, int &fl, int &sl) {
+  if (size >= SMALL_BLOCK_SIZE) {
+    size += ((size_t)1 << (tlsf_fls(size) - SL_INDEX_LOG2)) - 1;
+  }
+
+  mapping_insert(size, fl, sl);
+}
+
+TLSFBlock *TLSFAllocator::search_suitable_block(int &fl, int &sl) {
+  if (fl >= FL_INDEX_COUNT)
+    return nullptr;
+  uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+
+  if (!sl_map) {
+    uint32_t fl_map = fl_bitmap & (~0u << (fl + 1));
+    if (!fl_map)
+      return nullptr;
+    fl = tlsf_ffs(fl_map);
+    sl_map = sl_bitmap[fl];
+  }
+
+  sl = tlsf_ffs(sl_map);
+  return block_at(blocks[fl][sl]);
+}
+
+void TLSFAllocator::insert_free_block(TLSFBlock *block) {
+  int fl, sl;
+  mapping_insert(block_size(block), fl, sl);
+  uint32_t offset = offset_of(block);
+  uint32_t head = blocks[fl][sl];
+  next_free(block) = head;
+  prev_free(block) = NIL;
+  if (head != NIL)
+    prev_free(block_at(head)) = offset;
+  blocks[fl][sl] = offset;
+  fl_bitmap |= 1u << fl;
+  sl_bitmap[fl] |= 1u << sl;
+  free_list_bytes += block_size(block);
+}
+
+void TLSFAllocator::remove_free_block(TLSFBlock *block) {
+  int fl, sl;
+  mapping_insert(block_size(block), fl, sl);
+  uint32_t next = next_free(block);
+  uint32_t prev = prev_free(block);
+  free_list_bytes -= block_size(block);
+  if (next != NIL)
+    prev_free(block_at(next)) = prev;
+  if (prev != NIL)
+    next_free(block_at(prev)) = next;
+
+  if (blocks[fl][sl] == offset_of(block)) {
+    blocks[fl][sl] = next;
+
+    if (next == NIL) {
+      sl_bitmap[fl] &= ~(1u << sl);
+      if (!sl_bitmap[fl])
+        fl_bitmap &= ~(1u << fl);
+    }
+  }
+}
+
+void TLSFAllocator::init(char *memory, size_t size) {
+  this->memory_start = memory;
+  if (size > NIL)
+    size = NIL;
+  this->total_size = size & ~(size_t)7;
+  requested_sizes.clear();
+  allocated_bytes = requested_bytes = free_list_bytes = 0;
+  fl_bitmap = 0;
+
+  for (int i = 0; i < FL_INDEX_COUNT; ++i) {
+    sl_bitmap[i] = 0;
+
+    for (int j = 0; j < SL_INDEX_COUNT; ++j) {
+      blocks[i][j] = NIL;
+    }
+  }
+
+  if (total_size < sizeof(TLSFBlock) + MIN_PAYLOAD) {
+    total_size = 0;
+    std::cout << "TLSF Allocator: Memory too small." << std::endl;
+    return;
+  }
+
+  TLSFBlock *root = block_at(0);
+  root->prev_phys = NIL;
+  set_block(root, total_size - sizeof(TLSFBlock), true);
+  insert_free_block(root);
+  if (!verbose)
+    return;
+  std::cout << "TLSF Allocator Initialized. Free Block: " << block_size(root)
+            << " bytes (" << FL_INDEX_COUNT << "x" << SL_INDEX_COUNT
+            << " lists)" << std::endl;
+}
+
+void *TLSFAllocator::malloc(size_t size) {
+  if (memory_start == nullptr || size > total_size)
+    return nullptr;
+  size_t adjusted = (size + 7) & ~(size_t)7;
+  if (adjusted < MIN_PAYLOAD)
+    adjusted = MIN_PAYLOAD;
+  int fl, sl;
+  mapping_search(adjusted, fl, sl);
+  TLSFBlock *block = search_suitable_block(fl, sl);
+
+  if (!block) {
+    if (verbose)
+      std::cout << "TLSF Allocator: No memory available." << std::endl;
+    return nullptr;
+  }
+
+  remove_free_block(block);
+  size_t available = block_size(block);
+
+  if (available >= adjusted + sizeof(TLSFBlock) + MIN_PAYLOAD) {
+    TLSFBlock *remainder = reinterpret_cast<TLSFBlock *>(
+        reinterpret_cast<char *>(block + 1) + adjusted);
+    set_block(remainder, available - adjusted - sizeof(TLSFBlock), true);
+    remainder->prev_phys = offset_of(block);
+    TLSFBlock *after = next_phys(remainder);
+    if (after)
+      after->prev_phys = offset_of(remainder);
+    insert_free_block(remainder);
+    available = adjusted;
+  }
+
+  set_block(block, available, false);
+  requested_sizes[offset_of(block) + sizeof(TLSFBlock)] = size;
+  allocated_bytes += available;
+  requested_bytes += size;
+  if (verbose)
+    std::cout << "TLSF Alloc: List (" << fl << ", " << sl << ") ("
+              << available << " bytes)" << std::endl;
+  return block + 1;
+}
+
+bool TLSFAllocator::owns(void *ptr) {
+  char *p = static_cast<char *>(ptr);
+  if (memory_start == nullptr || p < memory_start ||
+      p >= memory_start + total_size)
+    return false;
+  return requested_sizes.count(static_cast<uint32_t>(p - memory_start)) > 0;
+}
+
+size_t TLSFAllocator::usable_size(void *ptr) {
+  return block_size(reinterpret_cast<TLSFBlock *>(ptr) - 1);
+}
+
+void TLSFAllocator::free(void *ptr) {
+  if (!ptr)
+    return;
+
+  if (!owns(ptr)) {
+    std::cout << "Error: Invalid address. Pointer is not the start of an "
+                 "allocated block."
+              << std::endl;
+    return;
+  }
+
+  auto requested = requested_sizes.find(
+      static_cast<uint32_t>(static_cast<char *>(ptr) - memory_start));
+  TLSFBlock *block = reinterpret_cast<TLSFBlock *>(ptr) - 1;
+  size_t size = block_size(block);
+  allocated_bytes -= size;
+  requested_bytes -= requested->second;
+  requested_sizes.erase(requested);
+
+  if (block->prev_phys != NIL) {
+    TLSFBlock *prev = block_at(block->prev_phys);
+
+    if (block_free(prev)) {
+      remove_free_block(prev);
+      size += block_size(prev) + sizeof(TLSFBlock);
+      block = prev;
+    }
+  }
+
+  set_block(block, size, true);
+  TLSFBlock *next = next_phys(block);
+
+  if (next && block_free(next)) {
+    remove_free_block(next);
+    set_block(block, size + sizeof(TLSFBlock) + block_size(next), true);
+    next = next_phys(block);
+  }
+
+  if (next)
+    next->prev_phys = offset_of(block);
+  insert_free_block(block);
+  if (verbose)
+    std::cout << "TLSF Free: " << block_size(block) << " bytes now free at "
+              << offset_of(block) + sizeof(TLSFBlock) << std::endl;
+}
+
+// The byte counts are kept up to date by malloc, free and the free-list
+// operations. The largest free block is in the highest non-empty list, so
+// only that list is scanned.
+void TLSFAllocator::collect_stats(size_t &used, size_t &free_bytes,
+                                  size_t &internal_frag,
+                                  size_t &largest_free) {
+  used = allocated_bytes;
+  free_bytes = free_list_bytes;
+  internal_frag = allocated_bytes - requested_bytes;
+  largest_free = 0;
+  if (!fl_bitmap)
+    return;
+  int fl = 31 - __builtin_clz(fl_bitmap);
+  int sl = 31 - __builtin_clz(sl_bitmap[fl]);
+
+  for (uint32_t offset = blocks[fl][sl]; offset != NIL;
+       offset = next_free(block_at(offset))) {
+    size_t size = block_size(block_at(offset));
+    if (size > largest_free)
+      largest_free = size;
+  }
+}
+
+void TLSFAllocator::debug_lists() {
+  std::cout << "--- TLSF Memory Map ---" << std::endl;
+  if (memory_start == nullptr || total_size == 0)
+    return;
+  TLSFBlock *block = block_at(0);
+
+  while (block != nullptr) {
+    uint32_t offset = offset_of(block);
+    std::cout << "  [" << offset << " - "
+              << offset + sizeof(TLSFBlock) + block_size(block) - 1 << "] "
+              << (block_free(block) ? "FREE" : "USED")
+              << " | Size: " << block_size(block) << " (+"
+              << sizeof(TLSFBlock) << " header)" << std::endl;
+    block = next_phys(block);
+  }
+
+  std::cout << "  First-level bitmap: 0x" << std::hex << fl_bitmap << std::dec
+            << std::endl;
+  std::cout << "-----------------------" << std::endl;
+}
@@ -0,0 +1,319 @@
+#include "../../include/belady.h"
+#include "../../include/cache.h"
+#include "../../include/page_replacer.h"
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <unordered_set>
+
+void BeladySet::compact() {
+  heap = std::priority_queue<std::pair<uint64_t, uint64_t>>();
+  for (const auto &entry : resident)
+    heap.push({entry.second, entry.first});
+}
+
+bool BeladySet::access(uint64_t key, uint64_t next_use) {
+  auto found = resident.find(key);
+  bool hit = found != resident.end();
+
+  if (hit) {
+    found->second = next_use;
+  } else {
+    if (resident.size() >= capacity) {
+      while (true) {
+        std::pair<uint64_t, uint64_t> top = heap.top();
+        heap.pop();
+        auto victim = resident.find(top.second);
+
+        if (victim != resident.end() && victim->second == top.first) {
+          resident.erase(victim);
+          break;
+        }
+      }
+    }
+
+    resident[key] = next_use;
+  }
+
+  heap.push({next_use, key});
+  if (heap.size() > 2 * capacity + 16)
+    compact();
+  return hit;
+}
+
+void BeladyAnalyzer::start() {
+  enabled = true;
+  references.clear();
+  physical.clear();
+}
+
+// The physical stream is only kept once it first differs from the issued
+// one, so runs without VM store each reference once.
+void BeladyAnalyzer::record(uint64_t address, uint64_t physical_address) {
+  if (!enabled)
+    return;
+
+  if (physical.empty() && physical_address != address)
+    physical.assign(references.begin(), references.end());
+  if (!physical.empty() || physical_address != address)
+    physical.push_back(physical_address);
+  references.push_back(address);
+}
+
+bool BeladyAnalyzer::load_file(const std::string &path) {
+  std::ifstream trace(path);
+
+  if (!trace) {
+    std::cout << "Error: Cannot open trace file " << path << std::endl;
+    return false;
+  }
+
+  std::string text;
+
+  while (std::getline(trace, text)) {
+    std::stringstream ss(text);
+    std::string token;
+    if (!(ss >> token) || token[0] == '#')
+      continue;
+    if ((token == "R" || token == "W" || token == "r" || token == "w") &&
+        !(ss >> token))
+      continue;
+
+    try {
+      uint64_t address = std::stoull(token, nullptr, 0);
+      record(address, address);
+    } catch (const std::exception &) {
+      continue;
+    }
+  }
+
+  std::cout << "Loaded " << references.size() << " references from " << path
+            << std::endl;
+  return true;
+}
+
+void BeladyAnalyzer::next_uses(const std::vector<uint64_t> &trace,
+                               size_t unit, std::vector<uint64_t> &next) {
+  std::unordered_map<uint64_t, uint64_t> seen;
+  next.assign(trace.size(), NEVER);
+
+  for (size_t i = trace.size(); i > 0; --i) {
+    uint64_t key = trace[i - 1] / unit;
+    auto found = seen.find(key);
+
+    if (found != seen.end()) {
+      next[i - 1] = found->second;
+      found->second = i - 1;
+    } else {
+      seen.emplace(key, i - 1);
+    }
+  }
+}
+
+void BeladyAnalyzer::print_gap(const char *policy, size_t misses,
+                               size_t optimal, const char *unit) {
+  size_t extra = misses > optimal ? misses - optimal : 0;
+  std::cout << "  " << std::left << std::setw(6) << policy << std::right
+            << misses << " " << unit << ", +" << extra << " over OPT ("
+            << std::fixed << std::setprecision(2)
+            << (optimal ? 100.0 * extra / optimal : 0.0) << "%)" << std::endl;
+}
+
+static size_t fifo_faults(const std::vector<uint64_t> &trace, size_t unit,
+                          size_t frames) {
+  std::unordered_set<uint64_t> resident;
+  std::deque<uint64_t> order;
+  size_t faults = 0;
+
+  for (uint64_t address : trace) {
+    uint64_t page = address / unit;
+    if (resident.count(page))
+      continue;
+
+    faults++;
+    if (resident.size() >= frames) {
+      resident.erase(order.front());
+      order.pop_front();
+    }
+    resident.insert(page);
+    order.push_back(page);
+  }
+
+  return faults;
+}
+
+static size_t lru_faults(const std::vector<uint64_t> &trace, size_t unit,
+                         size_t frames) {
+  std::list<uint64_t> order;
+  std::unordered_map<uint64_t, std::list<uint64_t>::iterator> resident;
+  size_t faults = 0;
+
+  for (uint64_t address : trace) {
+    uint64_t page = address / unit;
+    auto found = resident.find(page);
+
+    if (found != resident.end()) {
+      order.splice(order.begin(), order, found->second);
+      continue;
+    }
+
+    faults++;
+    if (resident.size() >= frames) {
+      resident.erase(order.back());
+      order.pop_back();
+    }
+    order.push_front(page);
+    resident[page] = order.begin();
+  }
+
+  return faults;
+}
+
+// Same hand discipline as VirtualMemoryManager's CLOCK.
+static size_t clock_faults(const std::vector<uint64_t> &trace, size_t unit,
+                           size_t frames) {
+  std::vector<uint64_t> slots;
+  std::vector<bool> referenced;
+  std::unordered_map<uint64_t, size_t> resident;
+  size_t hand = 0;
+  size_t faults = 0;
+
+  for (uint64_t address : trace) {
+    uint64_t page = address / unit;
+    auto found = resident.find(page);
+
+    if (found != resident.end()) {
+      referenced[found->second] = true;
+      continue;
+    }
+
+    faults++;
+    if (slots.size() < frames) {
+      resident[page] = slots.size();
+      slots.push_back(page);
+      referenced.push_back(true);
+      continue;
+    }
+
+    while (referenced[hand]) {
+      referenced[hand] = false;
+      hand = (hand + 1) % frames;
+    }
+
+    resident.erase(slots[hand]);
+    resident[page] = hand;
+    slots[hand] = page;
+    referenced[hand] = true;
+    hand = (hand + 1) % frames;
+  }
+
+  return faults;
+}
+
+static size_t replacer_faults(ReplacementPolicy policy,
+                              const std::vector<uint64_t> &trace, size_t unit,
+                              size_t frames) {
+  std::unique_ptr<PageReplacer> replacer = create_page_replacer(policy, frames);
+  std::unordered_set<uint64_t> resident;
+  size_t faults = 0;
+
+  for (uint64_t address : trace) {
+    uint64_t page = address / unit;
+
+    if (resident.count(page)) {
+      replacer->on_hit(page);
+      continue;
+    }
+
+    faults++;
+    if (resident.size() >= frames)
+      resident.erase(replacer->victim(page));
+    replacer->on_fault(page);
+    resident.insert(page);
+  }
+
+  return faults;
+}
+
+void BeladyAnalyzer::report_frames(size_t page_size, size_t frames) const {
+  if (page_size == 0 || frames == 0)
+    return;
+
+  std::vector<uint64_t> next;
+  next_uses(references, page_size, next);
+  BeladySet set(frames);
+  size_t optimal = 0;
+
+  for (size_t i = 0; i < references.size(); ++i) {
+    if (!set.access(references[i] / page_size, next[i]))
+      optimal++;
+  }
+  next.clear();
+  next.shrink_to_fit();
+
+  std::cout << "VM (" << page_size << "B pages, " << frames
+            << " frames): OPT " << optimal << " faults" << std::endl;
+  print_gap("FIFO", fifo_faults(references, page_size, frames), optimal,
+            "faults");
+  print_gap("LRU", lru_faults(references, page_size, frames), optimal,
+            "faults");
+  print_gap("CLOCK", clock_faults(references, page_size, frames), optimal,
+            "faults");
+
+  static const std::pair<ReplacementPolicy, const char *> adaptive[] = {
+      {ReplacementPolicy::ARC, "ARC"},
+      {ReplacementPolicy::CAR, "CAR"},
+      {ReplacementPolicy::TWO_Q, "2Q"},
+      {ReplacementPolicy::LIRS, "LIRS"}};
+
+  for (const auto &policy : adaptive) {
+    print_gap(policy.second,
+              replacer_faults(policy.first, references, page_size, frames),
+              optimal, "faults");
+  }
+}
+
+void BeladyAnalyzer::report_cache(int id, size_t size, size_t block_size,
+                                  size_t ways) const {
+  const std::vector<uint64_t> &trace = physical.empty() ? references : physical;
+  size_t sets = size / (block_size * ways);
+  if (sets == 0)
+    return;
+
+  std::vector<uint64_t> next;
+  next_uses(trace, block_size, next);
+  std::vector<BeladySet> opt(sets, BeladySet(ways));
+  size_t optimal = 0;
+
+  for (size_t i = 0; i < trace.size(); ++i) {
+    uint64_t line = trace[i] / block_size;
+    if (!opt[line % sets].access(line, next[i]))
+      optimal++;
+  }
+  next.clear();
+  next.shrink_to_fit();
+  opt.clear();
+
+  std::cout << "L" << id << " (" << size << "B, " << block_size << "B blocks, "
+            << ways << "-way): OPT " << optimal << " misses" << std::endl;
+
+  static const std::pair<CacheReplacementPolicy, const char *> online[] = {
+      {CacheReplacementPolicy::FIFO, "FIFO"},
+      {CacheReplacementPolicy::LRU, "LRU"},
+      {CacheReplacementPolicy::LFU, "LFU"}};
+
+  for (const auto &policy : online) {
+    std::unique_ptr<CacheLevel> level(
+        create_cache_level(id, size, block_size, ways));
+    level->set_policy(policy.first);
+
+    for (uint64_t address : trace)
+      level->access(address, false);
+
+    print_gap(policy.second, level->get_misses(), optimal, "misses");
+  }
+}
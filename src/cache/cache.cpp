@@ -1,5 +1,41 @@
 #include "../../include/cache.h"
 #include <iomanip>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// Bitmask of the ways whose tag equals the probe. Whole vectors are compared
+// where the instruction set allows it and the tail falls back to scalar.
+static uint64_t match_tags(const uint64_t *tags, size_t ways, uint64_t tag) {
+  uint64_t mask = 0;
+  size_t i = 0;
+#if defined(__AVX2__)
+  __m256i probe = _mm256_set1_epi64x(static_cast<long long>(tag));
+
+  for (; i + 4 <= ways; i += 4) {
+    __m256i line =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tags + i));
+    int eq = _mm256_movemask_pd(
+        _mm256_castsi256_pd(_mm256_cmpeq_epi64(line, probe)));
+    mask |= static_cast<uint64_t>(eq) << i;
+  }
+#elif defined(__SSE4_1__)
+  __m128i probe = _mm_set1_epi64x(static_cast<long long>(tag));
+
+  for (; i + 2 <= ways; i += 2) {
+    __m128i line = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags + i));
+    int eq = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(line, probe)));
+    mask |= static_cast<uint64_t>(eq) << i;
+  }
+#endif
+
+  for (; i < ways; ++i) {
+    if (tags[i] == tag)
+      mask |= (uint64_t)1 << i;
+  }
+
+  return mask;
+}
 
 CacheLevel::CacheLevel(int id, size_t size, size_t block_size,
                        size_t associativity)
@@ -12,96 +48,515 @@ CacheLevel::CacheLevel(int id, size_t size, size_t block_size,
     this->associativity = 1;
   }
 
+  if (this->associativity > MAX_ASSOCIATIVITY)
+    this->associativity = MAX_ASSOCIATIVITY;
   num_sets = size / (this->block_size * this->associativity);
   if (num_sets == 0)
     num_sets = 1;  
-  sets.resize(num_sets);
-
-  for (auto &set : sets) {
-    set.blocks.resize(this->associativity);
-    set.fifo_next_victim = 0;
-  }
+  tags.assign(num_sets * this->associativity, 0);
+  last_access.assign(num_sets * this->associativity, 0);
+  ready_at.assign(num_sets * this->associativity, 0);
+  access_counts.assign(num_sets * this->associativity, 0);
+  valid_bits.assign(num_sets, 0);
+  dirty_bits.assign(num_sets, 0);
+  prefetched_bits.assign(num_sets, 0);
+  fifo_next.assign(num_sets, 0);
+  plru_bits.assign(num_sets, 0);
+  rrpv.assign(num_sets * RRPV_WORDS, 0);
 }
 
 void CacheLevel::set_policy(CacheReplacementPolicy p) {
   policy = p;
 }
 
-bool CacheLevel::access(size_t address, bool is_write) {
-  timer++;
-  size_t index = (address / block_size) % num_sets;
-  size_t tag = address / (block_size * num_sets);
-  CacheSet &set = sets[index];
+namespace {
 
-  for (size_t i = 0; i < set.blocks.size(); ++i) {
+struct DynamicGeometry {
+  size_t block_size;
+  size_t num_sets;
+  size_t associativity;
+  size_t index(size_t address) const { return (address / block_size) % num_sets; }
+  uint64_t tag(size_t address) const {
+    return address / (block_size * num_sets);
+  }
+  size_t ways() const { return associativity; }
+};
 
-    if (set.blocks[i].valid && set.blocks[i].tag == tag) {
-      hits++;
-      set.blocks[i].last_access_time = timer;
-      set.blocks[i].access_count++;
+template <size_t BlockSize, size_t NumSets, size_t Ways> struct StaticGeometry {
+  static constexpr int BLOCK_SHIFT = __builtin_ctzll(BlockSize);
+  static constexpr int SET_SHIFT = __builtin_ctzll(NumSets);
+  size_t index(size_t address) const {
+    return (address >> BLOCK_SHIFT) & (NumSets - 1);
+  }
+  uint64_t tag(size_t address) const {
+    return address >> (BLOCK_SHIFT + SET_SHIFT);
+  }
+  static constexpr size_t ways() { return Ways; }
+};
 
-      if (is_write) {
-        set.blocks[i].dirty = true;
-      }
+} // namespace
 
-      return true;
-    }
+// Tree-PLRU keeps ways - 1 bits per set in heap order (node 1 is the root);
+// each bit points towards the less recently used half. Trees over a way
+// count that is not a power of two never descend into empty subtrees.
+int CacheLevel::plru_victim(size_t set, size_t ways) const {
+  uint64_t bits = plru_bits[set];
+  size_t node = 1;
+  size_t leaves = 1;
+  while (leaves < ways)
+    leaves <<= 1;
+  size_t first = 0;
+
+  for (size_t span = leaves; span > 1; span >>= 1) {
+    size_t right_first = first + span / 2;
+    bool right = (bits >> node) & 1;
+    if (right_first >= ways)
+      right = false;
+    if (right)
+      first = right_first;
+    node = node * 2 + (right ? 1 : 0);
+  }
+
+  return static_cast<int>(first);
+}
+
+void CacheLevel::plru_touch(size_t set, size_t way, size_t ways) {
+  uint64_t &bits = plru_bits[set];
+  size_t node = 1;
+  size_t leaves = 1;
+  while (leaves < ways)
+    leaves <<= 1;
+  size_t first = 0;
+
+  for (size_t span = leaves; span > 1; span >>= 1) {
+    size_t right_first = first + span / 2;
+    bool right = way >= right_first;
+    uint64_t bit = (uint64_t)1 << node;
+    bits = right ? bits & ~bit : bits | bit;
+    if (right)
+      first = right_first;
+    node = node * 2 + (right ? 1 : 0);
   }
+}
 
-  misses++;
-  int victim_idx = -1;
+// RRPVs are 2 bits per line, 32 lines per word. The victim is the first line
+// predicted for distant re-reference (RRPV 3); if there is none, every line
+// ages by one, which cannot carry because no field is at 3.
+int CacheLevel::rrip_victim(size_t set, size_t ways) {
+  uint64_t *words = &rrpv[set * RRPV_WORDS];
 
-  for (size_t i = 0; i < set.blocks.size(); ++i) {
+  while (true) {
 
-    if (!set.blocks[i].valid) {
-      victim_idx = i;
-      break;
+    for (size_t k = 0; k * 32 < ways; ++k) {
+      uint64_t distant = words[k] & (words[k] >> 1) & rrpv_lanes(k, ways);
+      if (distant)
+        return static_cast<int>(k * 32 + __builtin_ctzll(distant) / 2);
+    }
+
+    for (size_t k = 0; k * 32 < ways; ++k) {
+      words[k] += rrpv_lanes(k, ways);
     }
   }
+}
 
-  if (victim_idx == -1) {
+void CacheLevel::set_rrpv(size_t set, size_t way, uint64_t value) {
+  uint64_t &word = rrpv[set * RRPV_WORDS + way / 32];
+  int shift = static_cast<int>(way % 32) * 2;
+  word = (word & ~((uint64_t)3 << shift)) | (value << shift);
+}
 
-    if (policy == CacheReplacementPolicy::FIFO) {
-      victim_idx = set.fifo_next_victim;
-      set.fifo_next_victim = (set.fifo_next_victim + 1) % associativity;
-    } else if (policy == CacheReplacementPolicy::LRU) {
-      size_t min_time = -1;
+uint64_t CacheLevel::rrpv_lanes(size_t word, size_t ways) {
+  size_t lanes = ways - word * 32;
+  if (lanes >= 32)
+    return 0x5555555555555555ull;
+  return 0x5555555555555555ull & (((uint64_t)1 << (lanes * 2)) - 1);
+}
 
-      for (size_t i = 0; i < set.blocks.size(); ++i) {
+// BRRIP inserts at distant RRPV except for one fill in BRRIP_PERIOD, which
+// keeps thrashing working sets from flushing the whole cache.
+uint64_t CacheLevel::brrip_insertion() {
+  brrip_fills = (brrip_fills + 1) % BRRIP_PERIOD;
+  return brrip_fills == 0 ? RRPV_MAX - 1 : RRPV_MAX;
+}
 
-        if (set.blocks[i].last_access_time < min_time) {
-          min_time = set.blocks[i].last_access_time;
-          victim_idx = i;
-        }
-      }
+// DRRIP set dueling: one set in every DUEL_PERIOD always uses SRRIP and the
+// next one always uses BRRIP. Misses in those leader sets move PSEL, and the
+// remaining follower sets use whichever leader is currently missing less.
+bool CacheLevel::drrip_uses_brrip(size_t set) const {
+  size_t slot = set % DUEL_PERIOD;
+  if (slot == 0)
+    return false;
+  if (slot == 1)
+    return true;
+  return psel > PSEL_MAX / 2;
+}
 
-    } else if (policy == CacheReplacementPolicy::LFU) {
-      size_t min_count = -1;
+void CacheLevel::drrip_leader_miss(size_t set) {
+  size_t slot = set % DUEL_PERIOD;
+  if (slot == 0 && psel < PSEL_MAX)
+    psel++;
+  else if (slot == 1 && psel > 0)
+    psel--;
+}
 
-      for (size_t i = 0; i < set.blocks.size(); ++i) {
+template <CacheReplacementPolicy P>
+int CacheLevel::choose_victim(size_t set, size_t ways) {
+  uint64_t all = ways == 64 ? ~(uint64_t)0 : ((uint64_t)1 << ways) - 1;
+  uint64_t invalid = ~valid_bits[set] & all;
+  if (invalid)
+    return __builtin_ctzll(invalid);
+  size_t base = set * ways;
+  int victim_idx = 0;
 
-        if (set.blocks[i].access_count < min_count) {
-          min_count = set.blocks[i].access_count;
-          victim_idx = i;
-        } else if (set.blocks[i].access_count == min_count) {
-          if (set.blocks[i].last_access_time <
-              set.blocks[victim_idx].last_access_time) {
-            victim_idx = i;
-          }
-        }
+  if (P == CacheReplacementPolicy::FIFO) {
+    victim_idx = fifo_next[set];
+    fifo_next[set] = (fifo_next[set] + 1) % ways;
+  } else if (P == CacheReplacementPolicy::LRU) {
+
+    for (size_t i = 1; i < ways; ++i) {
+      if (last_access[base + i] < last_access[base + victim_idx])
+        victim_idx = i;
+    }
+
+  } else if (P == CacheReplacementPolicy::LFU) {
+
+    for (size_t i = 1; i < ways; ++i) {
+      uint32_t count = access_counts[base + i];
+      uint32_t best = access_counts[base + victim_idx];
+
+      if (count < best || (count == best && last_access[base + i] <
+                                                last_access[base + victim_idx])) {
+        victim_idx = i;
       }
     }
+
+  } else if (P == CacheReplacementPolicy::PLRU) {
+    victim_idx = plru_victim(set, ways);
+  } else {
+    victim_idx = rrip_victim(set, ways);
+  }
+
+  return victim_idx;
+}
+
+template <CacheReplacementPolicy P>
+void CacheLevel::on_hit(size_t set, size_t way, size_t ways) {
+  if (P == CacheReplacementPolicy::PLRU)
+    plru_touch(set, way, ways);
+  else if (P == CacheReplacementPolicy::SRRIP ||
+           P == CacheReplacementPolicy::BRRIP ||
+           P == CacheReplacementPolicy::DRRIP)
+    set_rrpv(set, way, 0);
+}
+
+template <CacheReplacementPolicy P>
+void CacheLevel::on_fill(size_t set, size_t way, size_t ways) {
+  if (P == CacheReplacementPolicy::PLRU) {
+    plru_touch(set, way, ways);
+  } else if (P == CacheReplacementPolicy::SRRIP) {
+    set_rrpv(set, way, RRPV_MAX - 1);
+  } else if (P == CacheReplacementPolicy::BRRIP) {
+    set_rrpv(set, way, brrip_insertion());
+  } else if (P == CacheReplacementPolicy::DRRIP) {
+    set_rrpv(set, way,
+             drrip_uses_brrip(set) ? brrip_insertion() : RRPV_MAX - 1);
+  }
+}
+
+// Demand accesses update hit/miss counts and train the prefetcher; lookups
+// count the same way but never allocate. Prefetch fills only install missing
+// lines, tagged so that a later demand hit counts as useful and an eviction
+// before any use counts as wasted. Victim fills install a line handed down
+// by the level above without counting an access.
+template <CacheReplacementPolicy P, typename Geometry>
+bool CacheLevel::access_with(size_t address, bool is_write, CacheAccess kind,
+                             const Geometry &geometry) {
+  timer++;
+  bool is_prefetch = kind == CacheAccess::PREFETCH;
+  size_t ways = geometry.ways();
+  size_t index = geometry.index(address);
+  uint64_t tag = geometry.tag(address);
+  uint64_t hit = match_tags(&tags[index * ways], ways, tag) & valid_bits[index];
+
+  if (hit && kind == CacheAccess::VICTIM_FILL) {
+    if (is_write && !write_through)
+      dirty_bits[index] |= hit;
+    return true;
+  }
+
+  if (hit && is_prefetch)
+    return true;
+
+  if (hit) {
+    int way = __builtin_ctzll(hit);
+    uint64_t bit = (uint64_t)1 << way;
+    bool prefetched_hit = prefetched_bits[index] & bit;
+    hits++;
+    size_t line = index * ways + way;
+    last_access[line] = timer;
+    access_counts[line]++;
+    on_hit<P>(index, way, ways);
+    if (is_write && !write_through)
+      dirty_bits[index] |= bit;
+
+    if (prefetched_hit) {
+      prefetches_useful++;
+      prefetched_bits[index] &= ~bit;
+    }
+
+    if (prefetcher)
+      run_prefetcher(address / block_size, true, prefetched_hit);
+    return true;
+  }
+
+  if (is_prefetch) {
+    prefetches_issued++;
+  } else if (kind != CacheAccess::VICTIM_FILL) {
+    misses++;
+    if (P == CacheReplacementPolicy::DRRIP)
+      drrip_leader_miss(index);
+
+    if (!displaced_by_prefetch.empty() &&
+        displaced_by_prefetch.erase(address / block_size)) {
+      pollution_misses++;
+    }
+
+    if (kind == CacheAccess::LOOKUP || (is_write && !write_allocate))
+      return false;
   }
 
-  CacheBlock &victim = set.blocks[victim_idx];
-  victim.valid = true;
-  victim.tag = tag;
-  victim.dirty = is_write;
-  victim.last_access_time = timer;
-  victim.access_count = 1;
+  int victim_idx = choose_victim<P>(index, ways);
+  size_t line = index * ways + victim_idx;
+  uint64_t bit = (uint64_t)1 << victim_idx;
+
+  if (valid_bits[index] & bit) {
+    if (prefetched_bits[index] & bit)
+      prefetches_unused++;
+    if (dirty_bits[index] & bit)
+      write_backs++;
+    if (track_victims)
+      victims.push_back({(tags[line] * num_sets + index) * block_size,
+                         (dirty_bits[index] & bit) != 0});
+    if (is_prefetch)
+      note_prefetch_victim(tags[line] * num_sets + index);
+  }
+
+  tags[line] = tag;
+  valid_bits[index] |= bit;
+  dirty_bits[index] = is_write && !write_through ? dirty_bits[index] | bit
+                                                : dirty_bits[index] & ~bit;
+  prefetched_bits[index] = is_prefetch ? prefetched_bits[index] | bit
+                                       : prefetched_bits[index] & ~bit;
+  last_access[line] = timer;
+  access_counts[line] = 1;
+  on_fill<P>(index, victim_idx, ways);
+  if (prefetcher && kind == CacheAccess::DEMAND)
+    run_prefetcher(address / block_size, false, false);
   return false;
 }
 
+template <typename Geometry>
+bool CacheLevel::dispatch(size_t address, bool is_write, CacheAccess kind,
+                          const Geometry &geometry) {
+  switch (policy) {
+  case CacheReplacementPolicy::LRU:
+    return access_with<CacheReplacementPolicy::LRU>(address, is_write,
+                                                    kind, geometry);
+  case CacheReplacementPolicy::LFU:
+    return access_with<CacheReplacementPolicy::LFU>(address, is_write,
+                                                    kind, geometry);
+  case CacheReplacementPolicy::PLRU:
+    return access_with<CacheReplacementPolicy::PLRU>(address, is_write,
+                                                     kind, geometry);
+  case CacheReplacementPolicy::SRRIP:
+    return access_with<CacheReplacementPolicy::SRRIP>(address, is_write,
+                                                      kind, geometry);
+  case CacheReplacementPolicy::BRRIP:
+    return access_with<CacheReplacementPolicy::BRRIP>(address, is_write,
+                                                      kind, geometry);
+  case CacheReplacementPolicy::DRRIP:
+    return access_with<CacheReplacementPolicy::DRRIP>(address, is_write,
+                                                      kind, geometry);
+  default:
+    return access_with<CacheReplacementPolicy::FIFO>(address, is_write,
+                                                     kind, geometry);
+  }
+}
+
+bool CacheLevel::perform(size_t address, bool is_write, CacheAccess kind) {
+  return dispatch(address, is_write, kind,
+                  DynamicGeometry{block_size, num_sets, associativity});
+}
+
+bool CacheLevel::contains(size_t address) const {
+  size_t index = (address / block_size) % num_sets;
+  uint64_t tag = address / (block_size * num_sets);
+  return match_tags(&tags[index * associativity], associativity, tag) &
+         valid_bits[index];
+}
+
+// Drops a line without counting an access, for coherence and inclusion
+// invalidations. Replacement state is left alone since invalid ways are
+// always filled first.
+bool CacheLevel::invalidate(size_t address, bool *was_dirty) {
+  size_t index = (address / block_size) % num_sets;
+  uint64_t tag = address / (block_size * num_sets);
+  uint64_t hit = match_tags(&tags[index * associativity], associativity, tag) &
+                 valid_bits[index];
+  if (was_dirty)
+    *was_dirty = (dirty_bits[index] & hit) != 0;
+  if (!hit)
+    return false;
+  valid_bits[index] &= ~hit;
+  dirty_bits[index] &= ~hit;
+  prefetched_bits[index] &= ~hit;
+  return true;
+}
+
+// Start address of every valid line.
+std::vector<size_t> CacheLevel::resident_lines() const {
+  std::vector<size_t> lines;
+
+  for (size_t set = 0; set < num_sets; ++set) {
+    for (uint64_t valid = valid_bits[set]; valid; valid &= valid - 1) {
+      size_t way = __builtin_ctzll(valid);
+      lines.push_back((tags[set * associativity + way] * num_sets + set) *
+                      block_size);
+    }
+  }
+
+  return lines;
+}
+
+bool CacheLevel::mark_dirty(size_t address) {
+  size_t index = (address / block_size) % num_sets;
+  uint64_t tag = address / (block_size * num_sets);
+  uint64_t hit = match_tags(&tags[index * associativity], associativity, tag) &
+                 valid_bits[index];
+  if (hit && !write_through)
+    dirty_bits[index] |= hit;
+  return hit != 0;
+}
+
+void CacheLevel::set_write_policy(bool write_through, bool write_allocate) {
+  this->write_through = write_through;
+  this->write_allocate = write_allocate;
+}
+
+// When enabled, every eviction of a valid line is appended to evicted(), and
+// every line a prefetch brings in to prefetched(), for the owner to drain.
+void CacheLevel::set_victim_tracking(bool enabled) {
+  track_victims = enabled;
+  victims.clear();
+  prefetch_fills.clear();
+}
+
+void CacheLevel::set_prefetcher(PrefetcherType type, int degree) {
+  prefetcher = create_prefetcher(type, degree, block_size);
+  prefetches_issued = prefetches_useful = prefetches_unused = 0;
+  pollution_misses = 0;
+  displaced_by_prefetch.clear();
+  displaced_order.clear();
+}
+
+// Lines pushed out by prefetch fills are remembered, up to the capacity of
+// the level, so a demand miss on one of them can be charged as pollution.
+void CacheLevel::note_prefetch_victim(size_t line) {
+  if (!displaced_by_prefetch.insert(line).second)
+    return;
+  displaced_order.push_back(line);
+
+  while (displaced_order.size() > num_sets * associativity) {
+    displaced_by_prefetch.erase(displaced_order.front());
+    displaced_order.pop_front();
+  }
+}
+
+void CacheLevel::run_prefetcher(size_t line, bool hit, bool prefetched_hit) {
+  prefetch_queue.clear();
+  prefetcher->on_access(line, hit, prefetched_hit, prefetch_queue);
+
+  for (size_t target : prefetch_queue) {
+    if (prefetch(target * block_size) && track_victims)
+      prefetch_fills.push_back(target * block_size);
+  }
+}
+
+// Arrival cycle of a prefetched line not yet used by a demand access, or 0.
+size_t CacheLevel::ready_time(size_t address) const {
+  size_t index = (address / block_size) % num_sets;
+  uint64_t tag = address / (block_size * num_sets);
+  uint64_t hit = match_tags(&tags[index * associativity], associativity, tag) &
+                 valid_bits[index] & prefetched_bits[index];
+  if (!hit)
+    return 0;
+  return ready_at[index * associativity + __builtin_ctzll(hit)];
+}
+
+void CacheLevel::set_ready_time(size_t address, size_t cycle) {
+  size_t index = (address / block_size) % num_sets;
+  uint64_t tag = address / (block_size * num_sets);
+  uint64_t hit = match_tags(&tags[index * associativity], associativity, tag) &
+                 valid_bits[index];
+  if (hit)
+    ready_at[index * associativity + __builtin_ctzll(hit)] = cycle;
+}
+
+template <size_t BlockSize, size_t NumSets, size_t Ways>
+StaticCacheLevel<BlockSize, NumSets, Ways>::StaticCacheLevel(int id)
+    : CacheLevel(id, BlockSize * NumSets * Ways, BlockSize, Ways) {}
+
+template <size_t BlockSize, size_t NumSets, size_t Ways>
+bool StaticCacheLevel<BlockSize, NumSets, Ways>::perform(size_t address,
+                                                         bool is_write,
+                                                         CacheAccess kind) {
+  return dispatch(address, is_write, kind,
+                  StaticGeometry<BlockSize, NumSets, Ways>());
+}
+
+// The simulator's default hierarchy plus common 64-byte-line geometries.
+template class StaticCacheLevel<8, 8, 1>;
+template class StaticCacheLevel<8, 16, 2>;
+template class StaticCacheLevel<64, 2, 8>;
+template class StaticCacheLevel<64, 64, 8>;
+template class StaticCacheLevel<64, 512, 8>;
+template class StaticCacheLevel<64, 1024, 16>;
+template class StaticCacheLevel<64, 8192, 16>;
+
+template <size_t BlockSize, size_t NumSets, size_t Ways>
+static CacheLevel *match_geometry(int id, size_t size, size_t block_size,
+                                  size_t associativity) {
+  if (block_size != BlockSize || associativity != Ways ||
+      size != BlockSize * NumSets * Ways)
+    return nullptr;
+  return new StaticCacheLevel<BlockSize, NumSets, Ways>(id);
+}
+
+static bool specialize_levels = true;
+
+void set_cache_specialization(bool enabled) { specialize_levels = enabled; }
+
+CacheLevel *create_cache_level(int id, size_t size, size_t block_size,
+                               size_t associativity) {
+  if (!specialize_levels)
+    return new CacheLevel(id, size, block_size, associativity);
+  using Factory = CacheLevel *(*)(int, size_t, size_t, size_t);
+  static const Factory factories[] = {
+      match_geometry<8, 8, 1>,       match_geometry<8, 16, 2>,
+      match_geometry<64, 2, 8>,      match_geometry<64, 64, 8>,
+      match_geometry<64, 512, 8>,    match_geometry<64, 1024, 16>,
+      match_geometry<64, 8192, 16>,
+  };
+
+  for (Factory factory : factories) {
+    CacheLevel *level = factory(id, size, block_size, associativity);
+    if (level)
+      return level;
+  }
+
+  return new CacheLevel(id, size, block_size, associativity);
+}
+
 double CacheLevel::get_hit_rate() const {
   size_t total = hits + misses;
   if (total == 0)
@@ -115,14 +570,32 @@ void CacheLevel::print_stats() const {
   std::cout << "  Misses: " << misses << std::endl;
   std::cout << "  Hit Rate: " << std::fixed << std::setprecision(2)
             << get_hit_rate() << "%" << std::endl;
+  std::cout << "  Write-backs: " << write_backs << std::endl;
+  if (!prefetcher)
+    return;
+  double accuracy =
+      prefetches_issued ? 100.0 * prefetches_useful / prefetches_issued : 0.0;
+  double coverage = prefetches_useful + misses
+                        ? 100.0 * prefetches_useful /
+                              (prefetches_useful + misses)
+                        : 0.0;
+  std::cout << "  Prefetcher (" << prefetcher->name()
+            << "): issued " << prefetches_issued << ", useful "
+            << prefetches_useful << " (accuracy " << accuracy
+            << "%, coverage " << coverage << "%)" << std::endl;
+  std::cout << "  Prefetch waste: " << prefetches_unused
+            << " evicted unused, " << pollution_misses << " pollution misses"
+            << std::endl;
 }
 
 void CacheLevel::reset_stats() {
   hits = 0;
   misses = 0;
+  write_backs = 0;
 }
 
-CacheHierarchy::CacheHierarchy() : l1(nullptr), l2(nullptr), l3(nullptr) {}
+CacheHierarchy::CacheHierarchy()
+    : l1(nullptr), l2(nullptr), l3(nullptr), victim_cache(nullptr) {}
 
 CacheHierarchy::~CacheHierarchy() {
   if (l1)
@@ -131,6 +604,8 @@ CacheHierarchy::~CacheHierarchy() {
     delete l2;
   if (l3)
     delete l3;
+  if (victim_cache)
+    delete victim_cache;
 }
 
 void CacheHierarchy::init(size_t l1_size, size_t l1_block_size, size_t l1_assoc,
@@ -143,9 +618,27 @@ void CacheHierarchy::init(size_t l1_size, size_t l1_block_size, size_t l1_assoc,
     delete l2;
   if (l3)
     delete l3;
-  l1 = new CacheLevel(1, l1_size, l1_block_size, l1_assoc);
-  l2 = new CacheLevel(2, l2_size, l2_block_size, l2_assoc);
-  l3 = new CacheLevel(3, l3_size, l3_block_size, l3_assoc);
+  if (victim_cache)
+    delete victim_cache;
+  victim_cache = nullptr;
+  inclusion = InclusionPolicy::NINE;
+  victim_hits = victim_misses = back_invalidations = 0;
+  l1 = create_cache_level(1, l1_size, l1_block_size, l1_assoc);
+  l2 = create_cache_level(2, l2_size, l2_block_size, l2_assoc);
+  l3 = create_cache_level(3, l3_size, l3_block_size, l3_assoc);
+  l1->set_victim_tracking(true);
+  l2->set_victim_tracking(true);
+  l3->set_victim_tracking(true);
+  latencies[0] = 4;
+  latencies[1] = 12;
+  latencies[2] = 40;
+  dram_latency = 200;
+  accesses = total_cycles = 0;
+  dram_reads = dram_writes = 0;
+  write_buffer.clear();
+  write_buffer_capacity = 8;
+  buffered_writes = coalesced_writes = forwarded_reads = 0;
+  write_buffer_stalls = 0;
   std::cout << "Cache System Initialized:" << std::endl;
   std::cout << "  L1: " << l1_size << "B, Block " << l1_block_size << "B, "
             << l1_assoc << "-way" << std::endl;
@@ -169,20 +662,347 @@ void CacheHierarchy::set_policy(CacheReplacementPolicy p) {
     std::cout << "LRU";
   else if (p == CacheReplacementPolicy::LFU)
     std::cout << "LFU";
+  else if (p == CacheReplacementPolicy::PLRU)
+    std::cout << "Tree-PLRU";
+  else if (p == CacheReplacementPolicy::SRRIP)
+    std::cout << "SRRIP";
+  else if (p == CacheReplacementPolicy::BRRIP)
+    std::cout << "BRRIP";
+  else if (p == CacheReplacementPolicy::DRRIP)
+    std::cout << "DRRIP";
   std::cout << std::endl;
 }
 
+void CacheHierarchy::set_prefetcher(int level, PrefetcherType type,
+                                    int degree) {
+  CacheLevel *levels[] = {l1, l2, l3};
+
+  for (int i = 0; i < 3; ++i) {
+    if (levels[i] && (level == 0 || level == i + 1))
+      levels[i]->set_prefetcher(type, degree);
+  }
+}
+
+CacheLevel *CacheHierarchy::level(int i) const {
+  return i == 0 ? l1 : i == 1 ? l2 : l3;
+}
+
+// Level 0 is DRAM.
+void CacheHierarchy::set_latency(int level, size_t cycles) {
+  if (level == 0)
+    dram_latency = cycles;
+  else if (level >= 1 && level <= 3)
+    latencies[level - 1] = cycles;
+}
+
+// Level 0 applies the policy to every level.
+void CacheHierarchy::set_write_policy(int level, bool write_through,
+                                      bool write_allocate) {
+  for (int i = 0; i < 3; ++i) {
+    if (this->level(i) && (level == 0 || level == i + 1))
+      this->level(i)->set_write_policy(write_through, write_allocate);
+  }
+}
+
+void CacheHierarchy::set_write_buffer(size_t entries) {
+  write_buffer_capacity = entries;
+  write_buffer.clear();
+}
+
+void CacheHierarchy::set_inclusion(InclusionPolicy p) {
+  inclusion = p;
+}
+
+// Zero entries removes the victim cache.
+void CacheHierarchy::set_victim_cache(size_t entries) {
+  if (victim_cache)
+    delete victim_cache;
+  victim_cache = nullptr;
+  victim_hits = victim_misses = 0;
+  if (!l1 || entries == 0)
+    return;
+  if (entries > CacheLevel::MAX_ASSOCIATIVITY)
+    entries = CacheLevel::MAX_ASSOCIATIVITY;
+  size_t block = l1->get_block_size();
+  victim_cache = create_cache_level(1, entries * block, block, entries);
+  victim_cache->set_policy(CacheReplacementPolicy::LRU);
+  victim_cache->set_victim_tracking(true);
+}
+
 void CacheHierarchy::access(size_t address, char type) {
   if (!l1 || !l2 || !l3)
     return;
   bool is_write = (type == 'W' || type == 'w');
-  bool l1_hit = l1->access(address, is_write);
-  if (l1_hit)
+  accesses++;
+
+  // A read of a line still waiting in the write buffer is answered from
+  // the buffer at L1 latency and leaves the levels untouched.
+  if (!is_write && retire_writes(address / l1->get_block_size()) &&
+      !l1->contains(address)) {
+    forwarded_reads++;
+    total_cycles += latencies[0];
     return;
-  bool l2_hit = l2->access(address, is_write);
-  if (l2_hit)
+  }
+
+  total_cycles += access_level(0, address, is_write, total_cycles);
+}
+
+// now is the cycle at which the request reaches level i.
+size_t CacheHierarchy::access_level(int i, size_t address, bool is_write,
+                                    size_t now) {
+  if (i == 3) {
+    if (is_write)
+      dram_writes++;
+    else
+      dram_reads++;
+    return dram_latency;
+  }
+
+  CacheLevel *cache = level(i);
+  size_t cycles = latencies[i];
+  bool exclusive = inclusion == InclusionPolicy::EXCLUSIVE && i > 0;
+  size_t ready = cache->ready_time(address);
+  bool hit = exclusive ? cache->lookup(address, is_write)
+                       : cache->access(address, is_write);
+  if (hit && ready > now + cycles)
+    cycles = ready - now;
+  bool kept = hit || !(exclusive || (is_write && !cache->allocates_on_write()));
+
+  if (!hit && kept && i == 0 && victim_cache) {
+    bool dirty = false;
+
+    if (victim_cache->invalidate(address, &dirty)) {
+      victim_hits++;
+      if (dirty)
+        l1->mark_dirty(address);
+      cycles += victim_latency;
+      hit = true;
+    } else {
+      victim_misses++;
+    }
+  }
+
+  handle_victims(i);
+
+  if (hit && exclusive && !is_write &&
+      cache->get_block_size() <= l1->get_block_size()) {
+    bool dirty = false;
+    cache->invalidate(address, &dirty);
+    if (dirty)
+      l1->mark_dirty(address);
+  }
+
+  if (!hit && (kept || !is_write))
+    cycles += access_level(i + 1, address, false, now + cycles);
+
+  fetch_prefetches(i, now + latencies[i]);
+
+  if (is_write && (!kept || cache->is_write_through())) {
+    cycles += i == 0 ? buffer_write(address)
+                     : access_level(i + 1, address, true, now + cycles);
+  }
+
+  return cycles;
+}
+
+// Lines prefetched into level i are read from the levels below like any
+// fill, starting when the prefetcher issued them. Their latency is not
+// charged to the access; each line records when it will have arrived.
+void CacheHierarchy::fetch_prefetches(int i, size_t now) {
+  std::vector<size_t> lines;
+  lines.swap(level(i)->prefetched());
+
+  for (size_t address : lines) {
+    size_t ready = now + access_level(i + 1, address, false, now);
+    level(i)->set_ready_time(address, ready);
+  }
+}
+
+// Drops the writes that have drained by now and reports whether one to the
+// given line is still waiting.
+bool CacheHierarchy::retire_writes(size_t line) {
+  bool pending = false;
+
+  while (!write_buffer.empty() && write_buffer.front().done <= total_cycles) {
+    write_buffer.pop_front();
+  }
+
+  for (const BufferedWrite &entry : write_buffer) {
+    if (entry.line == line)
+      pending = true;
+  }
+
+  return pending;
+}
+
+// Returns the cycles the core stalls: none unless the buffer is full, in
+// which case it waits for the oldest entry. Without a buffer every write
+// pays the full latency of the levels below.
+size_t CacheHierarchy::buffer_write(size_t address) {
+  size_t line = address / l1->get_block_size();
+
+  if (retire_writes(line)) {
+    coalesced_writes++;
+    return 0;
+  }
+
+  buffered_writes++;
+  if (write_buffer_capacity == 0)
+    return access_level(1, address, true, total_cycles + latencies[0]);
+  size_t now = total_cycles + latencies[0];
+  size_t stall = 0;
+
+  if (write_buffer.size() >= write_buffer_capacity) {
+    if (write_buffer.front().done > now)
+      stall = write_buffer.front().done - now;
+    write_buffer.pop_front();
+    write_buffer_stalls += stall;
+  }
+
+  size_t start = now + stall;
+  if (!write_buffer.empty() && write_buffer.back().done > start)
+    start = write_buffer.back().done;
+  write_buffer.push_back(
+      {line, start + access_level(1, address, true, start)});
+  return stall;
+}
+
+// L1 victims go to the victim cache first, if there is one, and leave the
+// level only when it spills them.
+void CacheHierarchy::handle_victims(int i) {
+  std::vector<CacheVictim> victims;
+  victims.swap(level(i)->evicted());
+
+  for (const CacheVictim &victim : victims) {
+
+    if (i == 0 && victim_cache) {
+      victim_cache->install(victim.address, victim.dirty);
+      std::vector<CacheVictim> spilled;
+      spilled.swap(victim_cache->evicted());
+      for (const CacheVictim &line : spilled)
+        evict_line(0, line);
+    } else {
+      evict_line(i, victim);
+    }
+  }
+}
+
+void CacheHierarchy::evict_line(int i, const CacheVictim &victim) {
+  bool dirty = victim.dirty;
+  if (inclusion == InclusionPolicy::INCLUSIVE && i > 0)
+    dirty |= back_invalidate(i, victim.address);
+
+  if (inclusion == InclusionPolicy::EXCLUSIVE && i < 2) {
+    level(i + 1)->install(victim.address, dirty);
+    if (dirty && level(i + 1)->is_write_through())
+      write_back(i + 1, victim.address);
+    handle_victims(i + 1);
     return;
-  l3->access(address, is_write);
+  }
+
+  if (dirty)
+    write_back(i, victim.address);
+}
+
+// Dirty data leaving level i lands in the nearest lower level that holds
+// the line and keeps dirty data, or in DRAM. Write-through levels on the
+// way pass it on whether they hold the line or not.
+void CacheHierarchy::write_back(int i, size_t address) {
+  for (int j = i + 1; j < 3; ++j) {
+    if (!level(j)->is_write_through() && level(j)->mark_dirty(address))
+      return;
+  }
+
+  dram_writes++;
+}
+
+// Removes every copy of the block above level i, including the victim
+// cache, and reports whether any of them was dirty.
+bool CacheHierarchy::back_invalidate(int i, size_t address) {
+  size_t block = level(i)->get_block_size();
+  size_t base = address - address % block;
+  bool any_dirty = false;
+  CacheLevel *upper[] = {l1, victim_cache, l2};
+  int count = i == 1 ? 2 : 3;
+
+  for (int u = 0; u < count; ++u) {
+    if (!upper[u])
+      continue;
+    size_t step = upper[u]->get_block_size();
+
+    for (size_t a = base; a < base + block; a += step) {
+      bool dirty = false;
+
+      if (upper[u]->invalidate(a, &dirty)) {
+        back_invalidations++;
+        any_dirty |= dirty;
+      }
+    }
+  }
+
+  return any_dirty;
+}
+
+// Duplicated lines are lines also held by a level further from the core;
+// the effective capacity counts every cached byte once.
+void CacheHierarchy::print_inclusion_stats() const {
+  static const char *names[] = {"NINE", "inclusive", "exclusive"};
+  CacheLevel *chain[] = {l1, victim_cache, l2, l3};
+  const char *labels[] = {"L1", "Victim", "L2", "L3"};
+  size_t granule = l1->get_block_size();
+  size_t capacity = 0;
+  std::unordered_set<size_t> cached;
+
+  for (CacheLevel *cache : chain) {
+    if (cache && cache->get_block_size() < granule)
+      granule = cache->get_block_size();
+  }
+
+  std::cout << "Hierarchy (" << names[static_cast<int>(inclusion)]
+            << "):" << std::endl;
+  std::cout << "  Duplicated lines:";
+
+  for (int c = 0; c < 4; ++c) {
+    if (!chain[c])
+      continue;
+    std::vector<size_t> lines = chain[c]->resident_lines();
+    size_t duplicated = 0;
+    capacity += chain[c]->get_capacity();
+
+    for (size_t address : lines) {
+      for (int d = c + 1; d < 4; ++d) {
+        if (chain[d] && chain[d]->contains(address)) {
+          duplicated++;
+          break;
+        }
+      }
+
+      for (size_t a = address; a < address + chain[c]->get_block_size();
+           a += granule)
+        cached.insert(a / granule);
+    }
+
+    if (c < 3)
+      std::cout << " " << labels[c] << " " << duplicated << " of "
+                << lines.size() << (c < 2 ? "," : "");
+  }
+
+  size_t effective = cached.size() * granule;
+  std::cout << std::endl;
+  std::cout << "  Effective capacity: " << effective << " of " << capacity
+            << " bytes (" << std::fixed << std::setprecision(2)
+            << (capacity ? 100.0 * effective / capacity : 0.0) << "%)"
+            << std::endl;
+
+  if (victim_cache) {
+    std::cout << "  Victim cache (" << victim_cache->get_capacity() /
+                                           victim_cache->get_block_size()
+              << " entries): " << victim_hits << " hits, " << victim_misses
+              << " misses" << std::endl;
+  }
+
+  if (inclusion == InclusionPolicy::INCLUSIVE)
+    std::cout << "  Back-invalidations: " << back_invalidations << std::endl;
 }
 
 void CacheHierarchy::print_stats() {
@@ -193,5 +1013,27 @@ void CacheHierarchy::print_stats() {
     l2->print_stats();
   if (l3)
     l3->print_stats();
+
+  if (l1 && l2 && l3) {
+    std::cout << "DRAM Traffic: " << dram_reads << " line fills, "
+              << dram_writes << " writes" << std::endl;
+
+    if (buffered_writes || coalesced_writes) {
+      std::cout << "Write Buffer (" << write_buffer_capacity
+                << " entries): " << buffered_writes << " writes, "
+                << coalesced_writes << " coalesced, " << forwarded_reads
+                << " reads forwarded, " << write_buffer_stalls
+                << " stall cycles" << std::endl;
+    }
+
+    double amat = accesses ? (double)total_cycles / accesses : 0.0;
+    print_inclusion_stats();
+    std::cout << "Latency (L1 " << latencies[0] << ", L2 " << latencies[1]
+              << ", L3 " << latencies[2] << ", DRAM " << dram_latency
+              << " cycles): " << total_cycles << " cycles over " << accesses
+              << " accesses, AMAT " << std::fixed << std::setprecision(2)
+              << amat << " cycles" << std::endl;
+  }
+
   std::cout << "========================\n" << std::endl;
-}
\ No newline at end of file
+}
@@ -0,0 +1,458 @@
+#include "../../include/coherence.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+static size_t ways_for(size_t size, size_t block_size, size_t ways) {
+  size_t lines = std::max<size_t>(size / block_size, 1);
+  return std::min(ways, lines);
+}
+
+static const char *protocol_name(CoherenceProtocol protocol) {
+  return protocol == CoherenceProtocol::MOESI ? "MOESI" : "MESI";
+}
+
+void MultiCoreSystem::init(int num_cores, CoherenceProtocol protocol,
+                           size_t l1_size, size_t l2_size, size_t l3_size,
+                           size_t block_size) {
+  if (num_cores < 1)
+    num_cores = 1;
+  if (num_cores > MAX_CORES)
+    num_cores = MAX_CORES;
+  if (block_size == 0)
+    block_size = 64;
+  this->protocol = protocol;
+  this->block_size = block_size;
+  cores.clear();
+  sharing.clear();
+  false_sharing_lines.clear();
+  bus_reads = bus_read_exclusives = upgrades = 0;
+  invalidations = cache_to_cache = 0;
+  back_invalidations = memory_write_backs = 0;
+
+  for (int i = 0; i < num_cores; ++i) {
+    std::unique_ptr<Core> core(new Core());
+    core->l1.reset(create_cache_level(1, l1_size, block_size,
+                                      ways_for(l1_size, block_size, 8)));
+    core->l2.reset(create_cache_level(2, l2_size, block_size,
+                                      ways_for(l2_size, block_size, 8)));
+    core->l1->set_victim_tracking(true);
+    core->l2->set_victim_tracking(true);
+    cores.push_back(std::move(core));
+  }
+
+  l3.reset(create_cache_level(3, l3_size, block_size,
+                              ways_for(l3_size, block_size, 16)));
+  l3->set_victim_tracking(true);
+  std::cout << "Multi-core system initialized: " << num_cores << " cores, "
+            << protocol_name(protocol) << ", Block " << block_size
+            << "B" << std::endl;
+  std::cout << "  Private L1: " << l1_size << "B, L2: " << l2_size
+            << "B; Shared inclusive L3: " << l3_size << "B" << std::endl;
+}
+
+void MultiCoreSystem::set_policy(CacheReplacementPolicy p) {
+  for (auto &core : cores) {
+    core->l1->set_policy(p);
+    core->l2->set_policy(p);
+  }
+
+  if (l3)
+    l3->set_policy(p);
+}
+
+// Words are 4 bytes; lines longer than 64 words are tracked in 64 equal
+// granules so the mask still fits one word.
+uint64_t MultiCoreSystem::word_bit(size_t address) const {
+  size_t granule = block_size / 64;
+  if (granule < WORD_SIZE)
+    granule = WORD_SIZE;
+  return (uint64_t)1 << ((address % block_size) / granule);
+}
+
+void MultiCoreSystem::access(int id, size_t address, bool is_write) {
+  if (id < 0 || id >= core_count())
+    return;
+  Core &core = *cores[id];
+  uint64_t line = address / block_size;
+
+  {
+    std::lock_guard<std::mutex> guard(core.lock);
+    if (is_write)
+      core.writes++;
+    else
+      core.reads++;
+    if (private_hit(core, line, address, is_write))
+      return;
+  }
+
+  std::lock_guard<std::mutex> bus_guard(bus);
+  std::vector<std::unique_lock<std::mutex>> guards;
+
+  for (auto &other : cores) {
+    guards.emplace_back(other->lock);
+  }
+
+  bus_access(id, line, address, is_write);
+}
+
+// Reads hit in any valid state and writes in M or E (E upgrades silently);
+// everything else needs the bus.
+bool MultiCoreSystem::private_hit(Core &core, uint64_t line, size_t address,
+                                  bool is_write) {
+  auto it = core.lines.find(line);
+  if (it == core.lines.end())
+    return false;
+
+  if (is_write) {
+    LineState state = it->second.state;
+    if (state != LineState::MODIFIED && state != LineState::EXCLUSIVE)
+      return false;
+    it->second.state = LineState::MODIFIED;
+    it->second.written |= word_bit(address);
+  }
+
+  touch_private(core, address, is_write);
+  return true;
+}
+
+void MultiCoreSystem::touch_private(Core &core, size_t address,
+                                    bool is_write) {
+  if (!core.l1->access(address, is_write))
+    core.l2->access(address, is_write);
+
+  for (const CacheVictim &victim : core.l1->evicted()) {
+    if (!core.l2->contains(victim.address))
+      leave_private(core, victim.address / block_size);
+  }
+
+  for (const CacheVictim &victim : core.l2->evicted()) {
+    if (!core.l1->contains(victim.address))
+      leave_private(core, victim.address / block_size);
+  }
+
+  core.l1->evicted().clear();
+  core.l2->evicted().clear();
+}
+
+// A line evicted from both private levels leaves the core. Dirty data goes
+// back to L3; the words it wrote are handed to the bus the next time this
+// core is snooped, so false sharing stays visible across the eviction.
+void MultiCoreSystem::leave_private(Core &core, uint64_t line) {
+  auto it = core.lines.find(line);
+  if (it == core.lines.end())
+    return;
+  LineState state = it->second.state;
+  if (state == LineState::MODIFIED || state == LineState::OWNED)
+    core.write_backs++;
+  if (it->second.written)
+    core.evicted_writes.push_back({line, it->second.written});
+  core.lines.erase(it);
+}
+
+void MultiCoreSystem::drain_evictions(Core &core) {
+  for (const auto &entry : core.evicted_writes) {
+    fold_writes(entry.first, entry.second);
+  }
+
+  core.evicted_writes.clear();
+}
+
+void MultiCoreSystem::fold_writes(uint64_t line, uint64_t written) {
+  if (written == 0)
+    return;
+  auto it = sharing.find(line);
+  if (it == sharing.end())
+    return;
+
+  for (uint64_t pending = it->second.pending; pending; pending &= pending - 1) {
+    it->second.words[__builtin_ctzll(pending)] |= written;
+  }
+}
+
+// One bus transaction: BusRd for a read miss, BusRdX for a write miss and
+// BusUpgr for a write to a shared or owned copy. Every other core is
+// snooped; a dirty or exclusive copy supplies the data cache to cache,
+// otherwise it comes from L3, whose victims are back-invalidated everywhere
+// to keep it inclusive.
+void MultiCoreSystem::bus_access(int id, uint64_t line, size_t address,
+                                 bool is_write) {
+  Core &core = *cores[id];
+  drain_evictions(core);
+  if (private_hit(core, line, address, is_write))
+    return;
+
+  auto own = core.lines.find(line);
+  LineState state = own == core.lines.end() ? LineState::INVALID
+                                            : own->second.state;
+  if (own != core.lines.end()) {
+    fold_writes(line, own->second.written);
+    own->second.written = 0;
+  }
+
+  if (!is_write)
+    bus_reads++;
+  else if (state == LineState::INVALID)
+    bus_read_exclusives++;
+  else
+    upgrades++;
+
+  bool shared = false;
+  bool supplied = false;
+  uint64_t invalidated = 0;
+
+  for (int k = 0; k < core_count(); ++k) {
+    if (k == id)
+      continue;
+    Core &other = *cores[k];
+    drain_evictions(other);
+    auto it = other.lines.find(line);
+    if (it == other.lines.end())
+      continue;
+    fold_writes(line, it->second.written);
+    it->second.written = 0;
+    LineState &other_state = it->second.state;
+
+    if (state == LineState::INVALID && other_state != LineState::SHARED)
+      supplied = true;
+
+    if (is_write) {
+      other.l1->invalidate(address);
+      other.l2->invalidate(address);
+      other.lines.erase(it);
+      other.invalidations_received++;
+      invalidations++;
+      invalidated |= (uint64_t)1 << k;
+      continue;
+    }
+
+    shared = true;
+
+    if (other_state == LineState::MODIFIED) {
+
+      if (protocol == CoherenceProtocol::MOESI) {
+        other_state = LineState::OWNED;
+      } else {
+        other_state = LineState::SHARED;
+        other.write_backs++;
+      }
+
+    } else if (other_state == LineState::EXCLUSIVE) {
+      other_state = LineState::SHARED;
+    }
+  }
+
+  if (supplied)
+    cache_to_cache++;
+
+  if (state == LineState::INVALID) {
+    auto record = sharing.find(line);
+
+    if (record != sharing.end() && (record->second.pending >> id) & 1) {
+      if (record->second.words[id] & word_bit(address)) {
+        core.true_sharing_misses++;
+      } else {
+        core.false_sharing_misses++;
+        false_sharing_lines[line]++;
+      }
+      record->second.pending &= ~((uint64_t)1 << id);
+      record->second.words[id] = 0;
+      if (record->second.pending == 0)
+        sharing.erase(record);
+    }
+  }
+
+  if (invalidated) {
+    SharingRecord &record = sharing[line];
+    if (record.words.empty())
+      record.words.assign(core_count(), 0);
+    record.pending |= invalidated;
+  }
+
+  if (state == LineState::INVALID && !supplied) {
+    l3->access(address, false);
+    std::vector<CacheVictim> victims;
+    victims.swap(l3->evicted());
+
+    for (const CacheVictim &victim : victims) {
+      back_invalidate(victim.address / block_size);
+    }
+  }
+
+  PrivateLine &entry = core.lines[line];
+  entry.state = is_write ? LineState::MODIFIED
+                : shared ? LineState::SHARED
+                         : LineState::EXCLUSIVE;
+  entry.written = is_write ? word_bit(address) : 0;
+  touch_private(core, address, is_write);
+}
+
+void MultiCoreSystem::back_invalidate(uint64_t line) {
+  size_t address = line * block_size;
+
+  for (int k = 0; k < core_count(); ++k) {
+    Core &core = *cores[k];
+    auto it = core.lines.find(line);
+    if (it == core.lines.end())
+      continue;
+    fold_writes(line, it->second.written);
+    LineState state = it->second.state;
+    if (state == LineState::MODIFIED || state == LineState::OWNED)
+      memory_write_backs++;
+    core.l1->invalidate(address);
+    core.l2->invalidate(address);
+    core.lines.erase(it);
+    back_invalidations++;
+  }
+}
+
+// Trace lines are "<R|W> <address>" or a bare address (a read), the same
+// format the miss-ratio analysis reads.
+static bool load_trace(const std::string &path,
+                       std::vector<std::pair<size_t, bool>> &trace) {
+  std::ifstream file(path);
+
+  if (!file) {
+    std::cout << "Error: Cannot open trace file " << path << std::endl;
+    return false;
+  }
+
+  std::string text;
+
+  while (std::getline(file, text)) {
+    std::stringstream ss(text);
+    std::string token;
+    if (!(ss >> token) || token[0] == '#')
+      continue;
+    bool is_write = token == "W" || token == "w";
+    if ((is_write || token == "R" || token == "r") && !(ss >> token))
+      continue;
+
+    try {
+      trace.push_back({std::stoull(token, nullptr, 0), is_write});
+    } catch (const std::exception &) {
+      continue;
+    }
+  }
+
+  return true;
+}
+
+// Trace i runs on core i. In parallel mode every core gets its own worker
+// thread; otherwise the traces are interleaved one reference at a time,
+// which is slower but reproducible.
+bool MultiCoreSystem::run_traces(const std::vector<std::string> &paths,
+                                 bool parallel) {
+  if (paths.empty() || paths.size() > cores.size()) {
+    std::cout << "Error: Expected between 1 and " << cores.size()
+              << " trace files" << std::endl;
+    return false;
+  }
+
+  std::vector<std::vector<std::pair<size_t, bool>>> traces(paths.size());
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (!load_trace(paths[i], traces[i]))
+      return false;
+  }
+
+  size_t total = 0;
+  for (const auto &trace : traces)
+    total += trace.size();
+
+  if (parallel) {
+    std::vector<std::thread> workers;
+
+    for (size_t i = 0; i < traces.size(); ++i) {
+      workers.emplace_back([this, i, &traces]() {
+        for (const auto &ref : traces[i])
+          access(static_cast<int>(i), ref.first, ref.second);
+      });
+    }
+
+    for (auto &worker : workers)
+      worker.join();
+  } else {
+
+    for (size_t step = 0, done = 0; done < total; ++step) {
+      for (size_t i = 0; i < traces.size(); ++i) {
+        if (step >= traces[i].size())
+          continue;
+        access(static_cast<int>(i), traces[i][step].first,
+               traces[i][step].second);
+        done++;
+      }
+    }
+  }
+
+  std::cout << "Processed " << total << " references on " << traces.size()
+            << " cores (" << (parallel ? "parallel" : "interleaved") << ")"
+            << std::endl;
+  return true;
+}
+
+void MultiCoreSystem::print_stats() {
+  if (!is_enabled())
+    return;
+  std::lock_guard<std::mutex> bus_guard(bus);
+  size_t true_sharing = 0, false_sharing = 0, write_backs = 0;
+
+  for (auto &core : cores) {
+    std::lock_guard<std::mutex> guard(core->lock);
+    drain_evictions(*core);
+  }
+
+  std::cout << "\n=== Multi-Core Statistics (" << protocol_name(protocol)
+            << ", " << cores.size() << " cores) ===" << std::endl;
+
+  for (size_t i = 0; i < cores.size(); ++i) {
+    const Core &core = *cores[i];
+    true_sharing += core.true_sharing_misses;
+    false_sharing += core.false_sharing_misses;
+    write_backs += core.write_backs;
+    std::cout << "Core " << i << ": " << core.reads << " reads, "
+              << core.writes << " writes, L1 " << std::fixed
+              << std::setprecision(2) << core.l1->get_hit_rate() << "%, L2 "
+              << core.l2->get_hit_rate() << "%, invalidated "
+              << core.invalidations_received << ", write-backs "
+              << core.write_backs << std::endl;
+  }
+
+  std::cout << "Shared L3: " << l3->get_hits() << " hits, "
+            << l3->get_misses() << " misses (" << l3->get_hit_rate() << "%)"
+            << std::endl;
+  std::cout << "Bus transactions: BusRd " << bus_reads << ", BusRdX "
+            << bus_read_exclusives << ", BusUpgr " << upgrades << std::endl;
+  std::cout << "Invalidations: " << invalidations << std::endl;
+  std::cout << "Cache-to-cache transfers: " << cache_to_cache << std::endl;
+  std::cout << "Write-backs to L3: " << write_backs << std::endl;
+  std::cout << "Back-invalidations: " << back_invalidations << " ("
+            << memory_write_backs << " dirty)" << std::endl;
+  std::cout << "Coherence misses: " << true_sharing + false_sharing
+            << " (true sharing " << true_sharing << ", false sharing "
+            << false_sharing << ")" << std::endl;
+
+  if (!false_sharing_lines.empty()) {
+    std::vector<std::pair<size_t, uint64_t>> worst;
+    for (const auto &entry : false_sharing_lines)
+      worst.push_back({entry.second, entry.first});
+    std::stable_sort(worst.begin(), worst.end(),
+                     [](const std::pair<size_t, uint64_t> &a,
+                        const std::pair<size_t, uint64_t> &b) {
+                       return a.first > b.first;
+                     });
+    if (worst.size() > 5)
+      worst.resize(5);
+    std::cout << "Most falsely shared lines:" << std::endl;
+
+    for (const auto &entry : worst) {
+      std::cout << "  Line at " << entry.second * block_size << ": "
+                << entry.first << " false sharing misses" << std::endl;
+    }
+  }
+
+  std::cout << "========================\n" << std::endl;
+}
@@ -0,0 +1,108 @@
+#include "../../include/prefetcher.h"
+
+void NextLinePrefetcher::on_access(size_t line, bool hit, bool prefetched_hit,
+                                   std::vector<size_t> &lines) {
+  if (hit && !prefetched_hit)
+    return;
+
+  for (int i = 1; i <= degree; ++i) {
+    lines.push_back(line + i);
+  }
+}
+
+StridePrefetcher::StridePrefetcher(int degree, size_t block_size)
+    : degree(degree), line_shift(0) {
+
+  while (((size_t)1 << line_shift) < block_size) {
+    line_shift++;
+  }
+}
+
+void StridePrefetcher::on_access(size_t line, bool hit, bool prefetched_hit,
+                                 std::vector<size_t> &lines) {
+  int region_shift = REGION_SHIFT > line_shift ? REGION_SHIFT - line_shift : 0;
+  size_t region = line >> region_shift;
+  Entry &entry = table[region % TABLE_SIZE];
+
+  if (!entry.valid || entry.region != region) {
+    entry = Entry();
+    entry.valid = true;
+    entry.region = region;
+    entry.last_line = line;
+    return;
+  }
+
+  long long stride = static_cast<long long>(line) -
+                     static_cast<long long>(entry.last_line);
+  if (stride == 0)
+    return;
+
+  if (stride == entry.stride) {
+    if (entry.confidence < 3)
+      entry.confidence++;
+  } else {
+    entry.stride = stride;
+    entry.confidence = 0;
+  }
+
+  entry.last_line = line;
+  if (entry.confidence < 1)
+    return;
+
+  for (int i = 1; i <= degree; ++i) {
+    long long target = static_cast<long long>(line) + stride * i;
+    if (target >= 0)
+      lines.push_back(static_cast<size_t>(target));
+  }
+}
+
+void StreamPrefetcher::on_access(size_t line, bool hit, bool prefetched_hit,
+                                 std::vector<size_t> &lines) {
+  clock++;
+  Stream *stream = nullptr;
+
+  for (Stream &s : streams) {
+    if (s.valid && line >= s.expected && line <= s.prefetched_upto) {
+      stream = &s;
+      break;
+    }
+  }
+
+  if (stream == nullptr) {
+    if (hit)
+      return;
+    stream = &streams[0];
+
+    for (Stream &s : streams) {
+      if (!s.valid || s.last_use < stream->last_use)
+        stream = &s;
+    }
+
+    stream->valid = true;
+    stream->prefetched_upto = line;
+  }
+
+  stream->expected = line + 1;
+  stream->last_use = clock;
+
+  while (stream->prefetched_upto < line + depth) {
+    lines.push_back(++stream->prefetched_upto);
+  }
+}
+
+std::unique_ptr<Prefetcher> create_prefetcher(PrefetcherType type, int degree,
+                                              size_t block_size) {
+  if (degree < 1)
+    degree = 1;
+
+  switch (type) {
+  case PrefetcherType::NEXT_LINE:
+    return std::unique_ptr<Prefetcher>(new NextLinePrefetcher(degree));
+  case PrefetcherType::STRIDE:
+    return std::unique_ptr<Prefetcher>(new StridePrefetcher(degree, block_size));
+  case PrefetcherType::STREAM:
+    return std::unique_ptr<Prefetcher>(new StreamPrefetcher(degree));
+  default:
+    return nullptr;
+  }
+}
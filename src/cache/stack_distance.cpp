@@ -0,0 +1,334 @@
+#include "../../include/stack_distance.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+void LruStackCounter::add(size_t slot, int delta) {
+  for (size_t i = slot + 1; i < tree.size(); i += i & (~i + 1)) {
+    tree[i] += delta;
+  }
+}
+
+int LruStackCounter::prefix(size_t slot) const {
+  int sum = 0;
+
+  for (size_t i = slot + 1; i > 0; i -= i & (~i + 1)) {
+    sum += tree[i];
+  }
+
+  return sum;
+}
+
+void LruStackCounter::renumber() {
+  std::vector<std::pair<size_t, uint64_t>> order;
+  order.reserve(last_slot.size());
+
+  for (const auto &entry : last_slot) {
+    order.push_back({entry.second, entry.first});
+  }
+
+  std::sort(order.begin(), order.end());
+  size_t capacity = std::max<size_t>(64, order.size() * 2);
+  tree.assign(capacity + 1, 0);
+
+  for (size_t i = 0; i < order.size(); ++i) {
+    last_slot[order[i].second] = i;
+    add(i, 1);
+  }
+
+  next_slot = order.size();
+}
+
+size_t LruStackCounter::access(uint64_t line) {
+  if (next_slot + 1 >= tree.size())
+    renumber();
+  size_t distance = COLD;
+  auto it = last_slot.find(line);
+
+  if (it != last_slot.end()) {
+    distance = prefix(next_slot - 1) - prefix(it->second);
+    add(it->second, -1);
+  }
+
+  add(next_slot, 1);
+  last_slot[line] = next_slot++;
+  return distance;
+}
+
+void LruStackCounter::forget(uint64_t line) {
+  auto it = last_slot.find(line);
+  if (it == last_slot.end())
+    return;
+  add(it->second, -1);
+  last_slot.erase(it);
+}
+
+// Log-linear buckets: distances below SUB_BUCKETS are exact, larger ones
+// split each power of two into SUB_BUCKETS equal ranges. Powers of two are
+// always bucket boundaries, so fully associative ratios stay exact.
+int StackDistanceAnalyzer::Histogram::bucket_of(size_t distance) {
+  if (distance < (size_t)SUB_BUCKETS)
+    return static_cast<int>(distance);
+  int fl = 63 - __builtin_clzll(distance);
+  int sub = static_cast<int>(distance >> (fl - 4)) & (SUB_BUCKETS - 1);
+  return SUB_BUCKETS + (fl - 4) * SUB_BUCKETS + sub;
+}
+
+size_t StackDistanceAnalyzer::Histogram::lower_bound(int bucket) {
+  if (bucket < SUB_BUCKETS)
+    return bucket;
+  int fl = (bucket - SUB_BUCKETS) / SUB_BUCKETS + 4;
+  size_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+  return (SUB_BUCKETS + sub) << (fl - 4);
+}
+
+void StackDistanceAnalyzer::Histogram::add(size_t distance, double scale) {
+  if (distance == LruStackCounter::COLD) {
+    cold += 1;
+    return;
+  }
+
+  buckets[bucket_of(static_cast<size_t>(distance * scale))] += 1;
+}
+
+double StackDistanceAnalyzer::Histogram::miss_ratio(size_t capacity,
+                                                    double total) const {
+  if (total <= 0)
+    return 0.0;
+  double misses = cold;
+
+  for (int b = bucket_of(capacity); b < NUM_BUCKETS; ++b) {
+    misses += buckets[b];
+  }
+
+  return misses / total;
+}
+
+// A reuse at fully associative distance D misses in an LRU set of the given
+// ways when at least that many of the D intervening lines map to its set,
+// which for uniformly spread lines is a Binomial(D, 1 / sets) tail.
+double StackDistanceAnalyzer::Histogram::assoc_miss_ratio(size_t sets,
+                                                          size_t ways,
+                                                          double total) const {
+  if (sets == 1)
+    return miss_ratio(ways, total);
+  if (total <= 0)
+    return 0.0;
+  double p = 1.0 / sets;
+  double misses = cold;
+
+  for (int b = 0; b < NUM_BUCKETS; ++b) {
+    if (buckets[b] == 0)
+      continue;
+    size_t low = lower_bound(b);
+    double d = b < SUB_BUCKETS ? low : low + (lower_bound(b + 1) - low) / 2.0;
+    double pmf = std::pow(1.0 - p, d);
+    double below = 0;
+
+    for (size_t k = 0; k < ways && k <= d; ++k) {
+      below += pmf;
+      pmf *= (d - k) / (k + 1) * p / (1.0 - p);
+    }
+
+    misses += buckets[b] * std::max(0.0, 1.0 - below);
+  }
+
+  return misses / total;
+}
+
+uint64_t StackDistanceAnalyzer::hash_line(uint64_t line) {
+  uint64_t z = line + 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return (z ^ (z >> 31)) % HASH_MODULUS;
+}
+
+double StackDistanceAnalyzer::rate() const {
+  return static_cast<double>(threshold) / HASH_MODULUS;
+}
+
+double StackDistanceAnalyzer::predicted_miss_ratio(size_t lines,
+                                                   size_t ways) const {
+  double total = static_cast<double>(sampled_references);
+  size_t sets = lines / ways;
+  if (!exact)
+    return full_hist.assoc_miss_ratio(sets, ways, total);
+  return set_hists[63 - __builtin_clzll(sets)].miss_ratio(ways, total);
+}
+
+void StackDistanceAnalyzer::start(size_t block_size, double sampling_rate,
+                                  size_t max_samples) {
+  if (block_size == 0)
+    block_size = 64;
+  if (sampling_rate <= 0 || sampling_rate > 1)
+    sampling_rate = 1;
+  this->block_size = block_size;
+  this->max_samples = max_samples;
+  threshold = static_cast<uint64_t>(sampling_rate * HASH_MODULUS);
+  if (threshold == 0)
+    threshold = 1;
+  exact = threshold == HASH_MODULUS && max_samples == 0;
+  references = 0;
+  sampled_references = 0;
+  full = LruStackCounter();
+  full_hist = Histogram();
+  set_stacks.clear();
+
+  for (int k = 0; k <= MAX_SET_LOG2; ++k) {
+    if (exact)
+      set_stacks.emplace_back((size_t)1 << k);
+    set_hists[k] = Histogram();
+  }
+
+  samples.clear();
+  shadows.clear();
+  const size_t shadow_geometries[][2] = {{16, 2}, {64, 4}, {256, 8}, {1024, 16}};
+
+  for (const auto &geometry : shadow_geometries) {
+    Shadow shadow{geometry[0], geometry[1], nullptr};
+    shadow.level.reset(create_cache_level(0, geometry[0] * block_size,
+                                          block_size, geometry[1]));
+    shadow.level->set_policy(CacheReplacementPolicy::LRU);
+    shadows.push_back(std::move(shadow));
+  }
+
+  enabled = true;
+}
+
+void StackDistanceAnalyzer::evict_sample() {
+  threshold = samples.rbegin()->first;
+
+  while (!samples.empty() && samples.rbegin()->first >= threshold) {
+    full.forget(samples.rbegin()->second);
+    samples.erase(std::prev(samples.end()));
+  }
+}
+
+void StackDistanceAnalyzer::record(size_t address) {
+  if (!enabled)
+    return;
+  references++;
+
+  for (Shadow &shadow : shadows) {
+    shadow.level->access(address, false);
+  }
+
+  uint64_t line = address / block_size;
+  uint64_t hash = hash_line(line);
+  if (hash >= threshold)
+    return;
+
+  if (max_samples > 0) {
+    samples.insert({hash, line});
+    if (samples.size() > max_samples)
+      evict_sample();
+    if (hash >= threshold)
+      return;
+  }
+
+  sampled_references++;
+  double scale = 1.0 / rate();
+  full_hist.add(full.access(line), scale);
+  if (!exact)
+    return;
+
+  for (int k = 0; k <= MAX_SET_LOG2; ++k) {
+    uint64_t set = line & (((uint64_t)1 << k) - 1);
+    set_hists[k].add(set_stacks[k][set].access(line), scale);
+  }
+}
+
+bool StackDistanceAnalyzer::analyze_file(const std::string &path) {
+  std::ifstream trace(path);
+
+  if (!trace) {
+    std::cout << "Error: Cannot open trace file " << path << std::endl;
+    return false;
+  }
+
+  std::string text;
+  size_t before = references;
+
+  while (std::getline(trace, text)) {
+    std::stringstream ss(text);
+    std::string token;
+    if (!(ss >> token) || token[0] == '#')
+      continue;
+    if ((token == "R" || token == "W" || token == "r" || token == "w") &&
+        !(ss >> token))
+      continue;
+
+    try {
+      record(std::stoull(token, nullptr, 0));
+    } catch (const std::exception &) {
+      continue;
+    }
+  }
+
+  std::cout << "Analyzed " << references - before << " references from "
+            << path << std::endl;
+  return true;
+}
+
+void StackDistanceAnalyzer::print_curve() {
+  std::cout << "\n=== Miss Ratio Curve (LRU, " << block_size
+            << "B blocks) ===" << std::endl;
+  std::cout << "References: " << references << " (sampled "
+            << sampled_references << ", rate " << std::fixed
+            << std::setprecision(4) << rate() << ")" << std::endl;
+
+  if (sampled_references == 0) {
+    std::cout << "No references recorded." << std::endl;
+    std::cout << std::setprecision(2);
+    return;
+  }
+
+  double total = static_cast<double>(sampled_references);
+  const int max_ways_log2 = 4;
+  std::cout << std::setprecision(2) << std::setw(10) << "Size" << std::setw(9)
+            << "Full";
+
+  for (int a = 0; a <= max_ways_log2; ++a) {
+    std::cout << std::setw(8) << (1 << a) << "w";
+  }
+
+  std::cout << std::endl;
+
+  for (int k = 0; k <= MAX_SET_LOG2; ++k) {
+    size_t lines = (size_t)1 << k;
+    std::cout << std::setw(9) << lines * block_size << "B" << std::setw(8)
+              << full_hist.miss_ratio(lines, total) * 100.0 << "%";
+
+    for (int a = 0; a <= max_ways_log2; ++a) {
+
+      if (a > k) {
+        std::cout << std::setw(9) << "-";
+      } else {
+        std::cout << std::setw(8)
+                  << predicted_miss_ratio(lines, (size_t)1 << a) * 100.0
+                  << "%";
+      }
+    }
+
+    std::cout << std::endl;
+  }
+
+  if (!exact)
+    std::cout << "Set-associative columns are estimated from sampled fully "
+                 "associative distances."
+              << std::endl;
+  std::cout << "Cross-check against CacheLevel (LRU, every reference):"
+            << std::endl;
+
+  for (const Shadow &shadow : shadows) {
+    size_t accesses = shadow.level->get_hits() + shadow.level->get_misses();
+    double simulated =
+        accesses ? 100.0 * shadow.level->get_misses() / accesses : 0.0;
+    std::cout << "  " << shadow.lines * block_size << "B " << shadow.ways
+              << "-way: predicted "
+              << predicted_miss_ratio(shadow.lines, shadow.ways) * 100.0
+              << "%, simulated " << simulated << "%" << std::endl;
+  }
+}
@@ -17,6 +17,9 @@ int main() {
     std::string action;
     ss >> action;
 
+    if (!action.empty() && action[0] == '#')
+      continue;
+
     if (action == "exit") {
       break;
     } else if (action == "init") {
@@ -33,15 +36,44 @@ int main() {
     else if (action == "help") {
       std::cout << "Commands:\n";
       std::cout << "  init <size>          - Initialize memory" << std::endl;
-      std::cout << "  enable_vm <page_size>- Enable Virtual Memory"
+      std::cout << "  enable_vm <page_size> [bits] - Enable Virtual Memory"
                 << std::endl;
       std::cout << "  malloc <size>        - Allocate bytes" << std::endl;
       std::cout << "  free <addr>          - Free bytes at relative address"
                 << std::endl;
+      std::cout << "  realloc <id> <size>  - Resize a block, in place if possible"
+                << std::endl;
+      std::cout << "  calloc <n> <size>    - Allocate n zeroed elements"
+                << std::endl;
       std::cout << "  read <addr>          - Read from address (Cache Test)"
                 << std::endl;
       std::cout << "  write <addr> <val>   - Write to address (Cache Test)"
                 << std::endl;
+      std::cout << "  bench <threads> <ops>- Concurrent allocator benchmark"
+                << std::endl;
+      std::cout << "  compact              - Slide live blocks together"
+                << std::endl;
+      std::cout << "  handle <id>          - Current address of a block ID"
+                << std::endl;
+      std::cout << "  mrc start [block] [rate] [max] - Record LRU stack distances"
+                << std::endl;
+      std::cout << "  mrc [show]           - Print the miss-ratio curve"
+                << std::endl;
+      std::cout << "  mrc file <path> ...  - Miss-ratio curve of a trace file"
+                << std::endl;
+      std::cout << "  opt start | stop     - Record references for the OPT bound"
+                << std::endl;
+      std::cout << "  opt [show]           - Compare policies against Belady OPT"
+                << std::endl;
+      std::cout << "  opt file <path>      - OPT bound for a trace file"
+                << std::endl;
+      std::cout << "  multicore init <cores> [mesi|moesi] [l1 l2 l3 [block]]"
+                << std::endl;
+      std::cout << "  multicore <read|write> <core> <addr> - Coherent access"
+                << std::endl;
+      std::cout << "  multicore run <parallel|interleaved> <trace> ..."
+                << std::endl;
+      std::cout << "  multicore stats      - Coherence statistics" << std::endl;
       std::cout << "  dump                 - Show memory map" << std::endl;
       std::cout << "  stats                - Show usage stats" << std::endl;
       std::cout << "  exit                 - Quit program" << std::endl;
@@ -74,6 +106,195 @@ int main() {
         std::cout << "Usage: free <block_id> OR free <address>" << std::endl;
       }
 
+    } else if (action == "realloc") {
+      int value;
+      size_t size;
+
+      if (ss >> value >> size) {
+
+        if (size == 0) {
+          mem.free_smart(value);
+          continue;
+        }
+
+        void *ptr = mem.realloc_smart(value, size);
+
+        if (ptr) {
+          std::cout << "Reallocated at address: " << mem.get_offset_from_ptr(ptr)
+                    << std::endl;
+        } else {
+          std::cout << "Reallocation failed" << std::endl;
+        }
+
+      } else {
+        std::cout << "Usage: realloc <block_id|address> <size>" << std::endl;
+      }
+
+    } else if (action == "calloc") {
+      size_t count, size;
+
+      if (ss >> count >> size) {
+        void *ptr = mem.calloc(count, size);
+
+        if (ptr) {
+          std::cout << "Allocated at address: " << mem.get_offset_from_ptr(ptr)
+                    << std::endl;
+        } else {
+          std::cout << "Allocation failed (Not enough memory)" << std::endl;
+        }
+
+      } else {
+        std::cout << "Usage: calloc <count> <size>" << std::endl;
+      }
+
+    } else if (action == "mrc") {
+      std::string mode;
+      ss >> mode;
+
+      if (mode == "start" || mode == "file") {
+        std::string path;
+        size_t block_size = 64, max_samples = 0;
+        double rate = 1.0;
+
+        if (mode == "file" && !(ss >> path)) {
+          std::cout << "Usage: mrc file <path> [block] [rate] [max_samples]"
+                    << std::endl;
+          continue;
+        }
+
+        ss >> block_size >> rate >> max_samples;
+
+        if (mode == "start") {
+          mem.start_mrc(block_size, rate, max_samples);
+        } else {
+          mem.analyze_trace_file(path, block_size, rate, max_samples);
+        }
+
+      } else if (mode == "stop") {
+        mem.stop_mrc();
+        std::cout << "Stack distance recording stopped." << std::endl;
+      } else if (mode == "" || mode == "show") {
+        mem.print_mrc();
+      } else {
+        std::cout << "Usage: mrc <start|stop|show|file> ..." << std::endl;
+      }
+
+    } else if (action == "opt") {
+      std::string mode;
+      ss >> mode;
+
+      if (mode == "start") {
+        mem.start_opt();
+      } else if (mode == "stop") {
+        mem.stop_opt();
+        std::cout << "OPT recording stopped." << std::endl;
+      } else if (mode == "file") {
+        std::string path;
+
+        if (ss >> path) {
+          mem.analyze_opt_file(path);
+        } else {
+          std::cout << "Usage: opt file <path>" << std::endl;
+        }
+
+      } else if (mode == "" || mode == "show") {
+        mem.print_opt();
+      } else {
+        std::cout << "Usage: opt <start|stop|show|file> ..." << std::endl;
+      }
+
+    } else if (action == "multicore") {
+      std::string mode;
+      ss >> mode;
+
+      if (mode == "init") {
+        int cores;
+        std::string protocol_str = "mesi";
+        size_t l1_size = 32768, l2_size = 262144, l3_size = 1048576;
+        size_t block_size = 64;
+
+        if (!(ss >> cores)) {
+          std::cout << "Usage: multicore init <cores> [mesi|moesi] "
+                       "[l1_size l2_size l3_size [block_size]]"
+                    << std::endl;
+          continue;
+        }
+
+        ss >> protocol_str >> l1_size >> l2_size >> l3_size >> block_size;
+
+        if (protocol_str != "mesi" && protocol_str != "moesi") {
+          std::cout << "Unknown protocol. Use: mesi, moesi" << std::endl;
+          continue;
+        }
+
+        mem.init_multicore(cores,
+                           protocol_str == "moesi" ? CoherenceProtocol::MOESI
+                                                   : CoherenceProtocol::MESI,
+                           l1_size, l2_size, l3_size, block_size);
+
+      } else if (mode == "read" || mode == "write") {
+        int core;
+        size_t addr;
+
+        if (!(ss >> core >> addr)) {
+          std::cout << "Usage: multicore <read|write> <core> <address>"
+                    << std::endl;
+        } else if (!mem.multicore_access(core, addr,
+                                         mode == "write" ? 'W' : 'R')) {
+          std::cout << "Error: No such core. Run 'multicore init' first."
+                    << std::endl;
+        } else {
+          std::cout << "Core " << core << " "
+                    << (mode == "write" ? "wrote" : "read") << " address "
+                    << addr << std::endl;
+        }
+
+      } else if (mode == "run") {
+        std::string schedule, path;
+        std::vector<std::string> paths;
+        ss >> schedule;
+
+        while (ss >> path) {
+          paths.push_back(path);
+        }
+
+        if ((schedule != "parallel" && schedule != "interleaved") ||
+            paths.empty()) {
+          std::cout << "Usage: multicore run <parallel|interleaved> <trace0> "
+                       "[trace1 ...]"
+                    << std::endl;
+        } else {
+          mem.run_multicore(paths, schedule == "parallel");
+        }
+
+      } else if (mode == "stats") {
+        mem.print_multicore_stats();
+      } else {
+        std::cout << "Usage: multicore <init|read|write|run|stats> ..."
+                  << std::endl;
+      }
+
+    } else if (action == "compact") {
+      mem.compact();
+    } else if (action == "handle") {
+      int id;
+
+      if (ss >> id) {
+        mem.print_handle(id);
+      } else {
+        std::cout << "Usage: handle <block_id>" << std::endl;
+      }
+
+    } else if (action == "bench") {
+      int threads;
+      size_t ops;
+
+      if (ss >> threads >> ops) {
+        mem.run_benchmark(threads, ops);
+      } else {
+        std::cout << "Usage: bench <max_threads> <ops_per_thread>" << std::endl;
+      }
+
     } else if (action == "dump") {
       mem.dump_memory();
     } else if (action == "stats") {
@@ -122,10 +343,184 @@ int main() {
         } else if (strategy_name == "buddy") {
           mem.set_strategy(AllocationStrategy::BUDDY);
           std::cout << "Strategy changed to Buddy Allocator." << std::endl;
+        } else if (strategy_name == "tlsf") {
+          mem.set_strategy(AllocationStrategy::TLSF);
+          std::cout << "Strategy changed to TLSF Allocator." << std::endl;
+        } else if (strategy_name == "slab") {
+          mem.set_strategy(AllocationStrategy::SLAB);
+          std::cout << "Strategy changed to Slab Allocator." << std::endl;
+        } else if (strategy_name.rfind("concurrent", 0) == 0) {
+          int arenas = 4;
+          std::stringstream arena_ss(strategy_name.substr(10));
+          arena_ss >> arenas;
+          mem.set_arena_count(arenas);
+          mem.set_strategy(AllocationStrategy::CONCURRENT);
+          std::cout << "Strategy changed to Concurrent Arenas." << std::endl;
+        } else {
+          std::cout << "Unknown strategy. Use: first fit, best fit, worst fit, "
+                       "buddy, tlsf, slab, concurrent [arenas]."
+                    << std::endl;
+        }
+
+      } else if (target == "compaction") {
+
+        if (strategy_name == "auto") {
+          mem.set_auto_compact(true);
+          std::cout << "Automatic compaction enabled." << std::endl;
+        } else if (strategy_name == "off") {
+          mem.set_auto_compact(false);
+          std::cout << "Automatic compaction disabled." << std::endl;
+        } else {
+          std::cout << "Usage: set compaction <auto|off>" << std::endl;
+        }
+
+      } else if (target == "cache" && strategy_name == "prefetch") {
+        std::string level_str, type_str;
+        int degree = 1;
+
+        if (!(ss >> level_str >> type_str)) {
+          std::cout << "Usage: set cache prefetch <l1|l2|l3|all> "
+                       "<none|nextline|stride|stream> [degree]"
+                    << std::endl;
+          continue;
+        }
+
+        ss >> degree;
+        int level = level_str == "l1"   ? 1
+                    : level_str == "l2" ? 2
+                    : level_str == "l3" ? 3
+                    : level_str == "all" ? 0
+                                         : -1;
+        PrefetcherType type = PrefetcherType::NONE;
+
+        if (type_str == "nextline") {
+          type = PrefetcherType::NEXT_LINE;
+        } else if (type_str == "stride") {
+          type = PrefetcherType::STRIDE;
+        } else if (type_str == "stream") {
+          type = PrefetcherType::STREAM;
+        } else if (type_str != "none") {
+          level = -1;
+        }
+
+        if (level < 0) {
+          std::cout << "Unknown prefetch setting. Use: set cache prefetch "
+                       "<l1|l2|l3|all> <none|nextline|stride|stream> [degree]"
+                    << std::endl;
+        } else {
+          mem.set_cache_prefetcher(level, type, degree);
+          std::cout << "Cache prefetcher set to " << type_str << " on "
+                    << level_str << "." << std::endl;
+        }
+
+      } else if (target == "cache" && strategy_name == "geometry") {
+        std::string level_str;
+        size_t size, block, ways;
+
+        if (ss >> level_str >> size >> block >> ways &&
+            (level_str == "l1" || level_str == "l2" || level_str == "l3") &&
+            block > 0 && ways > 0 && ways <= CacheLevel::MAX_ASSOCIATIVITY &&
+            size >= block * ways) {
+          mem.set_cache_geometry(level_str[1] - '0', size, block, ways);
+        } else {
+          std::cout << "Usage: set cache geometry <l1|l2|l3> <size> <block> "
+                       "<ways> (1-64 ways, size >= block * ways)"
+                    << std::endl;
+        }
+
+      } else if (target == "cache" && strategy_name == "specialize") {
+        std::string mode;
+        ss >> mode;
+
+        if (mode == "on" || mode == "off") {
+          std::cout << "Specialized cache levels "
+                    << (mode == "on" ? "enabled." : "disabled.") << std::endl;
+          mem.set_cache_specialization(mode == "on");
+        } else {
+          std::cout << "Usage: set cache specialize <on|off>" << std::endl;
+        }
+
+      } else if (target == "cache" && strategy_name == "latency") {
+        std::string level_str;
+        size_t cycles;
+
+        if (ss >> level_str >> cycles &&
+            (level_str == "l1" || level_str == "l2" || level_str == "l3" ||
+             level_str == "dram")) {
+          int level = level_str == "dram" ? 0 : level_str[1] - '0';
+          mem.set_cache_latency(level, cycles);
+          std::cout << "Cache latency of " << level_str << " set to "
+                    << cycles << " cycles." << std::endl;
+        } else {
+          std::cout << "Usage: set cache latency <l1|l2|l3|dram> <cycles>"
+                    << std::endl;
+        }
+
+      } else if (target == "cache" && strategy_name == "write") {
+        std::string level_str, write_str, allocate_str = "allocate";
+        ss >> level_str >> write_str >> allocate_str;
+        int level = level_str == "l1"    ? 1
+                    : level_str == "l2"  ? 2
+                    : level_str == "l3"  ? 3
+                    : level_str == "all" ? 0
+                                         : -1;
+
+        if (level < 0 || (write_str != "back" && write_str != "through") ||
+            (allocate_str != "allocate" && allocate_str != "noallocate")) {
+          std::cout << "Usage: set cache write <l1|l2|l3|all> <back|through> "
+                       "[allocate|noallocate]"
+                    << std::endl;
+        } else {
+          mem.set_cache_write_policy(level, write_str == "through",
+                                     allocate_str == "allocate");
+          std::cout << "Cache write policy on " << level_str << " set to write-"
+                    << write_str << ", "
+                    << (allocate_str == "allocate" ? "write-allocate"
+                                                   : "no-write-allocate")
+                    << "." << std::endl;
+        }
+
+      } else if (target == "cache" && strategy_name == "writebuffer") {
+        size_t entries;
+
+        if (ss >> entries) {
+          mem.set_cache_write_buffer(entries);
+          std::cout << "Write buffer set to " << entries << " entries."
+                    << std::endl;
         } else {
-          std::cout
-              << "Unknown strategy. Use: first fit, best fit, worst fit, buddy."
-              << std::endl;
+          std::cout << "Usage: set cache writebuffer <entries>" << std::endl;
+        }
+
+      } else if (target == "cache" && strategy_name == "inclusion") {
+        std::string mode;
+        ss >> mode;
+
+        if (mode == "nine") {
+          mem.set_cache_inclusion(InclusionPolicy::NINE);
+        } else if (mode == "inclusive") {
+          mem.set_cache_inclusion(InclusionPolicy::INCLUSIVE);
+        } else if (mode == "exclusive") {
+          mem.set_cache_inclusion(InclusionPolicy::EXCLUSIVE);
+        } else {
+          std::cout << "Usage: set cache inclusion <nine|inclusive|exclusive>"
+                    << std::endl;
+          continue;
+        }
+
+        std::cout << "Cache hierarchy set to " << mode << "." << std::endl;
+
+      } else if (target == "cache" && strategy_name == "victim") {
+        size_t entries;
+
+        if (ss >> entries) {
+          mem.set_cache_victim_entries(entries);
+          if (entries == 0)
+            std::cout << "Victim cache disabled." << std::endl;
+          else
+            std::cout << "Victim cache set to " << entries << " entries."
+                      << std::endl;
+        } else {
+          std::cout << "Usage: set cache victim <entries>" << std::endl;
         }
 
       } else if (target == "cache" && strategy_name == "policy") {
@@ -142,12 +537,24 @@ int main() {
           } else if (policy_str == "lfu") {
             mem.set_cache_policy(CacheReplacementPolicy::LFU);
             std::cout << "Cache Policy set to LFU" << std::endl;
+          } else if (policy_str == "plru") {
+            mem.set_cache_policy(CacheReplacementPolicy::PLRU);
+          } else if (policy_str == "srrip") {
+            mem.set_cache_policy(CacheReplacementPolicy::SRRIP);
+          } else if (policy_str == "brrip") {
+            mem.set_cache_policy(CacheReplacementPolicy::BRRIP);
+          } else if (policy_str == "drrip") {
+            mem.set_cache_policy(CacheReplacementPolicy::DRRIP);
           } else {
-            std::cout << "Unknown policy. Use: fifo, lru, lfu" << std::endl;
+            std::cout << "Unknown policy. Use: fifo, lru, lfu, plru, srrip, "
+                         "brrip, drrip"
+                      << std::endl;
           }
 
         } else {
-          std::cout << "Usage: set cache policy <fifo|lru|lfu>" << std::endl;
+          std::cout << "Usage: set cache policy "
+                       "<fifo|lru|lfu|plru|srrip|brrip|drrip>"
+                    << std::endl;
         }
 
       } else if (target == "vm") {
@@ -166,36 +573,161 @@ int main() {
             } else if (policy_str == "clock") {
               mem.set_vm_policy(ReplacementPolicy::CLOCK);
               std::cout << "VM Policy set to CLOCK" << std::endl;
+            } else if (policy_str == "eclock") {
+              mem.set_vm_policy(ReplacementPolicy::ENHANCED_CLOCK);
+              std::cout << "VM Policy set to Enhanced CLOCK" << std::endl;
+            } else if (policy_str == "wsclock") {
+              size_t window = 0;
+              ss >> window;
+              mem.set_vm_policy(ReplacementPolicy::WSCLOCK, window);
+              std::cout << "VM Policy set to WSClock" << std::endl;
+            } else if (policy_str == "arc") {
+              mem.set_vm_policy(ReplacementPolicy::ARC);
+              std::cout << "VM Policy set to ARC" << std::endl;
+            } else if (policy_str == "car") {
+              mem.set_vm_policy(ReplacementPolicy::CAR);
+              std::cout << "VM Policy set to CAR" << std::endl;
+            } else if (policy_str == "2q") {
+              mem.set_vm_policy(ReplacementPolicy::TWO_Q);
+              std::cout << "VM Policy set to 2Q" << std::endl;
+            } else if (policy_str == "lirs") {
+              mem.set_vm_policy(ReplacementPolicy::LIRS);
+              std::cout << "VM Policy set to LIRS" << std::endl;
             } else {
-              std::cout << "Unknown policy. Use: fifo, lru, clock" << std::endl;
+              std::cout << "Unknown policy. Use: fifo, lru, clock, eclock, "
+                           "wsclock, arc, car, 2q, lirs"
+                        << std::endl;
             }
 
           } else {
-            std::cout << "Usage: set vm policy <fifo|lru|clock>" << std::endl;
+            std::cout << "Usage: set vm policy <fifo|lru|clock|eclock|"
+                         "wsclock [window]|arc|car|2q|lirs>"
+                      << std::endl;
           }
 
         } else if (strategy_name == "latency") {
           int ms;
 
           if (ss >> ms) {
-            mem.set_vm_latency(ms);
-            std::cout << "VM Disk Latency set to " << ms << "ms" << std::endl;
+            int write_ms = ms;
+            ss >> write_ms;
+            mem.set_vm_latency(ms, write_ms);
+            std::cout << "VM Disk Latency set to " << ms << "ms";
+            if (write_ms != ms)
+              std::cout << " (writes " << write_ms << "ms)";
+            std::cout << std::endl;
           } else {
-            std::cout << "Usage: set vm latency <ms>" << std::endl;
+            std::cout << "Usage: set vm latency <read_ms> [write_ms]"
+                      << std::endl;
+          }
+
+        } else if (strategy_name == "writeback") {
+          size_t pages;
+
+          if (ss >> pages && pages > 0) {
+            mem.set_vm_writeback_batch(pages);
+            std::cout << "VM write-back batch set to " << pages << " page(s)"
+                      << std::endl;
+          } else {
+            std::cout << "Usage: set vm writeback <pages>" << std::endl;
+          }
+
+        } else if (strategy_name == "disk") {
+          size_t channels, queue_depth = 0;
+
+          if (ss >> channels && channels > 0) {
+            ss >> queue_depth;
+            mem.configure_vm_disk(channels, queue_depth);
+            std::cout << "VM Disk set to " << channels
+                      << " channel(s), queue depth " << queue_depth
+                      << std::endl;
+          } else {
+            std::cout << "Usage: set vm disk <channels> [queue_depth]"
+                      << std::endl;
+          }
+
+        } else if (strategy_name == "cpu") {
+          size_t us;
+
+          if (ss >> us) {
+            mem.set_vm_cpu_time(us);
+            std::cout << "VM CPU time set to " << us << "us per access"
+                      << std::endl;
+          } else {
+            std::cout << "Usage: set vm cpu <us>" << std::endl;
+          }
+
+        } else if (strategy_name == "tlb") {
+          std::string level_str, policy_str = "lru";
+          size_t entries, ways = 0;
+
+          if (!(ss >> level_str >> entries) ||
+              (level_str != "l1" && level_str != "l2")) {
+            std::cout << "Usage: set vm tlb <l1|l2> <entries> [ways] "
+                         "[lru|fifo|lfu|plru]"
+                      << std::endl;
+            continue;
+          }
+
+          ss >> ways >> policy_str;
+          CacheReplacementPolicy policy = CacheReplacementPolicy::LRU;
+
+          if (policy_str == "fifo") {
+            policy = CacheReplacementPolicy::FIFO;
+          } else if (policy_str == "lfu") {
+            policy = CacheReplacementPolicy::LFU;
+          } else if (policy_str == "plru") {
+            policy = CacheReplacementPolicy::PLRU;
+          } else if (policy_str != "lru") {
+            std::cout << "Unknown TLB policy. Use: lru, fifo, lfu, plru"
+                      << std::endl;
+            continue;
+          }
+
+          mem.configure_tlb(level_str == "l1" ? 1 : 2, entries, ways, policy);
+          if (entries == 0)
+            std::cout << "TLB " << level_str << " disabled." << std::endl;
+          else
+            std::cout << "TLB " << level_str << " set to " << entries
+                      << " entries." << std::endl;
+
+        } else if (strategy_name == "walk") {
+          size_t cycles;
+
+          if (ss >> cycles) {
+            mem.set_tlb_walk_latency(cycles);
+            std::cout << "Page walk latency set to " << cycles
+                      << " cycles per level." << std::endl;
+          } else {
+            std::cout << "Usage: set vm walk <cycles>" << std::endl;
           }
 
         } else {
-          std::cout << "Unknown VM setting. Use: policy, latency" << std::endl;
+          std::cout << "Unknown VM setting. Use: policy, latency, writeback, "
+                       "disk, cpu, tlb, walk"
+                    << std::endl;
         }
       }
 
     } else if (action == "enable_vm") {
       size_t page_size;
+      int address_bits = 16;
+
+      if (ss >> page_size && page_size > 0) {
+        if (!(ss >> address_bits))
+          address_bits = 16;
 
-      if (ss >> page_size) {
-        mem.enable_vm(page_size);
+        if (address_bits < 8 || address_bits > 57 ||
+            page_size > (static_cast<size_t>(1) << address_bits)) {
+          std::cout << "Address width must be 8-57 bits and cover at least "
+                       "one page."
+                    << std::endl;
+        } else {
+          mem.enable_vm(page_size, address_bits);
+        }
       } else {
-        std::cout << "Usage: enable_vm <page_size>" << std::endl;
+        std::cout << "Usage: enable_vm <page_size> [address_bits]"
+                  << std::endl;
       }
     }
   }
@@ -0,0 +1,389 @@
+#include "../../include/page_replacer.h"
+#include <iostream>
+
+// All lists keep their most recently used page at the front, except the
+// CAR clocks, whose hand sits at the front and which insert at the back.
+
+void ArcReplacer::move_to(size_t page, List list) {
+  auto found = nodes.find(page);
+  if (found != nodes.end())
+    lists[found->second.list].erase(found->second.it);
+
+  lists[list].push_front(page);
+  nodes[page] = {list, lists[list].begin()};
+}
+
+void ArcReplacer::drop_lru(List list) {
+  size_t page = lists[list].back();
+  lists[list].pop_back();
+  nodes.erase(page);
+}
+
+void ArcReplacer::on_hit(size_t page) { move_to(page, T2); }
+
+size_t ArcReplacer::replace(bool incoming_in_b2) {
+  size_t t1 = lists[T1].size();
+  bool from_t1 = t1 > 0 && (lists[T2].empty() || t1 > target ||
+                            (incoming_in_b2 && t1 == target));
+  size_t page = lists[from_t1 ? T1 : T2].back();
+  move_to(page, from_t1 ? B1 : B2);
+  return page;
+}
+
+size_t ArcReplacer::victim(size_t incoming) {
+  auto found = nodes.find(incoming);
+  size_t b1 = lists[B1].size();
+  size_t b2 = lists[B2].size();
+
+  if (found != nodes.end() && found->second.list == B1) {
+    ghost_hits[0]++;
+    size_t delta = b2 > b1 ? b2 / b1 : 1;
+    target = target + delta < capacity ? target + delta : capacity;
+    return replace(false);
+  }
+
+  if (found != nodes.end() && found->second.list == B2) {
+    ghost_hits[1]++;
+    size_t delta = b1 > b2 ? b1 / b2 : 1;
+    target = target > delta ? target - delta : 0;
+    return replace(true);
+  }
+
+  if (lists[T1].size() + b1 >= capacity) {
+    if (lists[T1].size() < capacity) {
+      drop_lru(B1);
+      return replace(false);
+    }
+
+    size_t page = lists[T1].back();
+    drop_lru(T1);
+    return page;
+  }
+
+  if (lists[T1].size() + lists[T2].size() + b1 + b2 >= 2 * capacity)
+    drop_lru(B2);
+  return replace(false);
+}
+
+void ArcReplacer::on_fault(size_t page) {
+  auto found = nodes.find(page);
+  bool ghost = found != nodes.end() &&
+               (found->second.list == B1 || found->second.list == B2);
+  move_to(page, ghost ? T2 : T1);
+}
+
+void ArcReplacer::print_stats() const {
+  std::cout << "  ARC: T1 " << lists[T1].size() << ", T2 " << lists[T2].size()
+            << ", target T1 " << target << " of " << capacity
+            << ", ghost hits B1 " << ghost_hits[0] << ", B2 " << ghost_hits[1]
+            << std::endl;
+}
+
+void CarReplacer::move_to(size_t page, List list) {
+  auto found = nodes.find(page);
+  if (found != nodes.end())
+    lists[found->second.list].erase(found->second.it);
+
+  std::list<size_t>::iterator it;
+  if (list == T1 || list == T2) {
+    it = lists[list].insert(lists[list].end(), page);
+  } else {
+    lists[list].push_front(page);
+    it = lists[list].begin();
+  }
+  nodes[page] = {list, it, false};
+}
+
+void CarReplacer::drop_lru(List list) {
+  size_t page = lists[list].back();
+  lists[list].pop_back();
+  nodes.erase(page);
+}
+
+void CarReplacer::on_hit(size_t page) { nodes[page].referenced = true; }
+
+size_t CarReplacer::victim(size_t incoming) {
+  size_t page;
+
+  while (true) {
+    size_t t1_goal = target > 1 ? target : 1;
+
+    if (lists[T1].size() >= t1_goal) {
+      page = lists[T1].front();
+
+      if (!nodes[page].referenced) {
+        move_to(page, B1);
+        break;
+      }
+
+      move_to(page, T2);
+    } else {
+      page = lists[T2].front();
+      Node &node = nodes[page];
+
+      if (!node.referenced) {
+        move_to(page, B2);
+        break;
+      }
+
+      node.referenced = false;
+      lists[T2].splice(lists[T2].end(), lists[T2], node.it);
+    }
+  }
+
+  auto found = nodes.find(incoming);
+  if (found == nodes.end()) {
+    if (lists[T1].size() + lists[B1].size() >= capacity)
+      drop_lru(B1);
+    else if (lists[T1].size() + lists[T2].size() + lists[B1].size() +
+                 lists[B2].size() >=
+             2 * capacity)
+      drop_lru(B2);
+  }
+
+  return page;
+}
+
+void CarReplacer::on_fault(size_t page) {
+  auto found = nodes.find(page);
+  size_t b1 = lists[B1].size();
+  size_t b2 = lists[B2].size();
+
+  if (found != nodes.end() && found->second.list == B1) {
+    ghost_hits[0]++;
+    size_t delta = b2 > b1 ? b2 / b1 : 1;
+    target = target + delta < capacity ? target + delta : capacity;
+    move_to(page, T2);
+  } else if (found != nodes.end() && found->second.list == B2) {
+    ghost_hits[1]++;
+    size_t delta = b1 > b2 ? b1 / b2 : 1;
+    target = target > delta ? target - delta : 0;
+    move_to(page, T2);
+  } else {
+    move_to(page, T1);
+  }
+}
+
+void CarReplacer::print_stats() const {
+  std::cout << "  CAR: T1 " << lists[T1].size() << ", T2 " << lists[T2].size()
+            << ", target T1 " << target << " of " << capacity
+            << ", ghost hits B1 " << ghost_hits[0] << ", B2 " << ghost_hits[1]
+            << std::endl;
+}
+
+TwoQueueReplacer::TwoQueueReplacer(size_t capacity) {
+  in_limit = capacity / 4 > 0 ? capacity / 4 : 1;
+  out_limit = capacity / 2 > 0 ? capacity / 2 : 1;
+}
+
+void TwoQueueReplacer::move_to(size_t page, List list) {
+  auto found = nodes.find(page);
+  if (found != nodes.end())
+    lists[found->second.list].erase(found->second.it);
+
+  lists[list].push_front(page);
+  nodes[page] = {list, lists[list].begin()};
+}
+
+void TwoQueueReplacer::on_hit(size_t page) {
+  if (nodes[page].list == AM)
+    move_to(page, AM);
+}
+
+size_t TwoQueueReplacer::victim(size_t incoming) {
+  if (lists[A1IN].size() > in_limit || lists[AM].empty()) {
+    size_t page = lists[A1IN].back();
+    move_to(page, A1OUT);
+    return page;
+  }
+
+  size_t page = lists[AM].back();
+  lists[AM].pop_back();
+  nodes.erase(page);
+  return page;
+}
+
+// A1out is trimmed here rather than in victim() so that the ghost of the
+// incoming page is seen before it can be dropped.
+void TwoQueueReplacer::on_fault(size_t page) {
+  auto found = nodes.find(page);
+
+  if (found != nodes.end() && found->second.list == A1OUT) {
+    ghost_hits++;
+    move_to(page, AM);
+  } else {
+    move_to(page, A1IN);
+  }
+
+  while (lists[A1OUT].size() > out_limit) {
+    nodes.erase(lists[A1OUT].back());
+    lists[A1OUT].pop_back();
+  }
+}
+
+void TwoQueueReplacer::print_stats() const {
+  std::cout << "  2Q: A1in " << lists[A1IN].size() << " (limit " << in_limit
+            << "), Am " << lists[AM].size() << ", A1out "
+            << lists[A1OUT].size() << " ghosts, " << ghost_hits
+            << " ghost hits" << std::endl;
+}
+
+LirsReplacer::LirsReplacer(size_t capacity) {
+  size_t hir_frames = capacity / 100 > 0 ? capacity / 100 : 1;
+  lir_limit = capacity > hir_frames ? capacity - hir_frames : 0;
+  ghost_limit = capacity;
+}
+
+void LirsReplacer::push_stack(size_t page, Node &node) {
+  if (node.in_stack)
+    stack.erase(node.stack_it);
+  stack.push_front(page);
+  node.stack_it = stack.begin();
+  node.in_stack = true;
+}
+
+void LirsReplacer::push_queue(size_t page, Node &node) {
+  if (node.in_queue)
+    queue.erase(node.queue_it);
+  node.queue_it = queue.insert(queue.end(), page);
+  node.in_queue = true;
+}
+
+// The bottom of S is always an LIR page; HIR pages and ghosts below the
+// last LIR page can never be promoted, so they leave the stack.
+void LirsReplacer::prune() {
+  while (!stack.empty()) {
+    size_t page = stack.back();
+    Node &node = nodes[page];
+    if (node.state == LIR)
+      break;
+
+    stack.pop_back();
+    node.in_stack = false;
+
+    if (node.state == GHOST) {
+      ghosts.erase(node.ghost_it);
+      nodes.erase(page);
+    }
+  }
+}
+
+void LirsReplacer::demote_bottom() {
+  prune();
+  if (stack.empty())
+    return;
+
+  size_t page = stack.back();
+  Node &node = nodes[page];
+  stack.pop_back();
+  node.in_stack = false;
+  node.state = HIR;
+  lir_count--;
+  push_queue(page, node);
+  prune();
+}
+
+void LirsReplacer::on_hit(size_t page) {
+  Node &node = nodes[page];
+
+  if (node.state == LIR) {
+    bool was_bottom = stack.back() == page;
+    push_stack(page, node);
+    if (was_bottom)
+      prune();
+    return;
+  }
+
+  if (node.in_stack) {
+    node.state = LIR;
+    lir_count++;
+    queue.erase(node.queue_it);
+    node.in_queue = false;
+    push_stack(page, node);
+    if (lir_count > lir_limit)
+      demote_bottom();
+    return;
+  }
+
+  push_stack(page, node);
+  push_queue(page, node);
+}
+
+size_t LirsReplacer::victim(size_t incoming) {
+  if (queue.empty())
+    demote_bottom();
+
+  size_t page = queue.front();
+  Node &node = nodes[page];
+  queue.pop_front();
+  node.in_queue = false;
+
+  if (node.in_stack) {
+    node.state = GHOST;
+    node.ghost_it = ghosts.insert(ghosts.end(), page);
+  } else {
+    nodes.erase(page);
+  }
+
+  return page;
+}
+
+void LirsReplacer::on_fault(size_t page) {
+  auto found = nodes.find(page);
+
+  if (found != nodes.end() && found->second.state == GHOST) {
+    Node &node = found->second;
+    ghost_hits++;
+    ghosts.erase(node.ghost_it);
+    node.state = LIR;
+    lir_count++;
+    push_stack(page, node);
+    if (lir_count > lir_limit)
+      demote_bottom();
+  } else {
+    Node &node = nodes[page];
+
+    if (lir_count < lir_limit) {
+      node.state = LIR;
+      lir_count++;
+      push_stack(page, node);
+    } else {
+      node.state = HIR;
+      push_stack(page, node);
+      push_queue(page, node);
+    }
+  }
+
+  while (ghosts.size() > ghost_limit) {
+    size_t ghost = ghosts.front();
+    ghosts.pop_front();
+    stack.erase(nodes[ghost].stack_it);
+    nodes.erase(ghost);
+  }
+}
+
+void LirsReplacer::print_stats() const {
+  std::cout << "  LIRS: " << lir_count << " LIR of " << lir_limit << ", "
+            << queue.size() << " HIR resident, " << ghosts.size()
+            << " ghosts, stack " << stack.size() << ", " << ghost_hits
+            << " ghost hits" << std::endl;
+}
+
+std::unique_ptr<PageReplacer> create_page_replacer(ReplacementPolicy policy,
+                                                   size_t capacity) {
+  if (capacity == 0)
+    return nullptr;
+
+  switch (policy) {
+  case ReplacementPolicy::ARC:
+    return std::unique_ptr<PageReplacer>(new ArcReplacer(capacity));
+  case ReplacementPolicy::CAR:
+    return std::unique_ptr<PageReplacer>(new CarReplacer(capacity));
+  case ReplacementPolicy::TWO_Q:
+    return std::unique_ptr<PageReplacer>(new TwoQueueReplacer(capacity));
+  case ReplacementPolicy::LIRS:
+    return std::unique_ptr<PageReplacer>(new LirsReplacer(capacity));
+  default:
+    return nullptr;
+  }
+}
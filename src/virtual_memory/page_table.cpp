@@ -0,0 +1,101 @@
+#include "../../include/page_table.h"
+#include <iostream>
+
+// Level 0 is the root. Lower levels get bits_per_level bits each and the
+// root takes the remainder, as on x86-64 where the top level can be partial.
+void RadixPageTable::init(int page_number_bits) {
+  page_bits = page_number_bits < 1 ? 1 : page_number_bits;
+  levels = page_bits < MAX_LEVELS ? page_bits : MAX_LEVELS;
+  bits_per_level = (page_bits + levels - 1) / levels;
+  levels = (page_bits + bits_per_level - 1) / bits_per_level;
+
+  for (int i = 0; i < MAX_LEVELS; ++i)
+    nodes_per_level[i] = 0;
+  root.reset(make_node(0));
+}
+
+size_t RadixPageTable::fanout(int level) const {
+  int bits = level == 0 ? page_bits - bits_per_level * (levels - 1)
+                        : bits_per_level;
+  return static_cast<size_t>(1) << bits;
+}
+
+size_t RadixPageTable::slot(size_t vpn, int level) const {
+  int shift = bits_per_level * (levels - 1 - level);
+  return (vpn >> shift) & (fanout(level) - 1);
+}
+
+RadixPageTable::Node *RadixPageTable::make_node(int level) {
+  Node *node = new Node();
+
+  if (level == levels - 1)
+    node->entries.resize(fanout(level));
+  else
+    node->children.resize(fanout(level));
+
+  nodes_per_level[level]++;
+  return node;
+}
+
+// Walks without allocating. depth receives the number of tables read, which
+// is fewer than the level count when the walk hits a missing directory.
+PageTableEntry *RadixPageTable::find(size_t vpn, int *depth) const {
+  const Node *node = root.get();
+
+  for (int level = 0; level < levels - 1; ++level) {
+    node = node->children[slot(vpn, level)].get();
+
+    if (!node) {
+      if (depth)
+        *depth = level + 1;
+      return nullptr;
+    }
+  }
+
+  if (depth)
+    *depth = levels;
+  return const_cast<PageTableEntry *>(
+      &node->entries[slot(vpn, levels - 1)]);
+}
+
+PageTableEntry &RadixPageTable::get(size_t vpn) {
+  Node *node = root.get();
+
+  for (int level = 0; level < levels - 1; ++level) {
+    std::unique_ptr<Node> &child = node->children[slot(vpn, level)];
+    if (!child)
+      child.reset(make_node(level + 1));
+    node = child.get();
+  }
+
+  return node->entries[slot(vpn, levels - 1)];
+}
+
+size_t RadixPageTable::table_bytes() const {
+  size_t bytes = 0;
+
+  for (int level = 0; level < levels; ++level)
+    bytes += nodes_per_level[level] * fanout(level) * ENTRY_BYTES;
+
+  return bytes;
+}
+
+size_t RadixPageTable::dense_bytes() const {
+  return (static_cast<size_t>(1) << page_bits) * ENTRY_BYTES;
+}
+
+void RadixPageTable::print_stats() const {
+  size_t tables = 0;
+  std::cout << "  Page Table: " << levels << " levels (";
+
+  for (int level = 0; level < levels; ++level) {
+    std::cout << (level ? "+" : "")
+              << (level == 0 ? page_bits - bits_per_level * (levels - 1)
+                             : bits_per_level);
+    tables += nodes_per_level[level];
+  }
+
+  std::cout << " bits), " << tables << " tables, " << table_bytes()
+            << " bytes (flat table: " << dense_bytes() << " bytes)"
+            << std::endl;
+}
@@ -0,0 +1,107 @@
+#include "../../include/tlb.h"
+#include <iomanip>
+#include <iostream>
+
+static const char *policy_name(CacheReplacementPolicy policy) {
+  switch (policy) {
+  case CacheReplacementPolicy::LRU:
+    return "LRU";
+  case CacheReplacementPolicy::LFU:
+    return "LFU";
+  case CacheReplacementPolicy::PLRU:
+    return "Tree-PLRU";
+  case CacheReplacementPolicy::SRRIP:
+    return "SRRIP";
+  case CacheReplacementPolicy::BRRIP:
+    return "BRRIP";
+  case CacheReplacementPolicy::DRRIP:
+    return "DRRIP";
+  default:
+    return "FIFO";
+  }
+}
+
+// Zero entries removes the level. Ways are clamped to the entry count.
+void Tlb::configure(int level, size_t entries, size_t ways,
+                    CacheReplacementPolicy policy) {
+  if (level < 1 || level > NUM_LEVELS)
+    return;
+  if (ways == 0 || ways > entries)
+    ways = entries;
+  if (ways > CacheLevel::MAX_ASSOCIATIVITY)
+    ways = CacheLevel::MAX_ASSOCIATIVITY;
+  configs[level - 1] = {entries, ways, policy};
+  reset();
+}
+
+void Tlb::reset() {
+  for (int i = 0; i < NUM_LEVELS; ++i) {
+    levels[i].reset();
+    if (configs[i].entries == 0)
+      continue;
+    levels[i].reset(create_cache_level(i + 1, configs[i].entries, 1,
+                                       configs[i].ways));
+    levels[i]->set_policy(configs[i].policy);
+  }
+
+  lookups = walks = walk_references = shootdowns = cycles = 0;
+}
+
+// Probes L1 then L2; every level probed is filled on a miss, so a page walk
+// leaves the translation in both.
+bool Tlb::lookup(size_t vpn) {
+  lookups++;
+
+  for (int i = 0; i < NUM_LEVELS; ++i) {
+    if (!levels[i])
+      continue;
+    cycles += latencies[i];
+    if (levels[i]->access(vpn, false))
+      return true;
+  }
+
+  return false;
+}
+
+void Tlb::record_walk(int table_levels) {
+  walks++;
+  walk_references += table_levels;
+  cycles += walk_latency * table_levels;
+}
+
+void Tlb::invalidate(size_t vpn) {
+  bool present = false;
+
+  for (int i = 0; i < NUM_LEVELS; ++i) {
+    if (levels[i] && levels[i]->invalidate(vpn))
+      present = true;
+  }
+
+  if (present)
+    shootdowns++;
+}
+
+void Tlb::print_stats() const {
+  static const char *names[] = {"L1 dTLB", "L2 TLB"};
+
+  for (int i = 0; i < NUM_LEVELS; ++i) {
+    if (!levels[i]) {
+      std::cout << "  " << names[i] << ": disabled" << std::endl;
+      continue;
+    }
+    std::cout << "  " << names[i] << " (" << configs[i].entries
+              << " entries, " << configs[i].ways << "-way, "
+              << policy_name(configs[i].policy)
+              << "): Hits " << levels[i]->get_hits() << ", Misses "
+              << levels[i]->get_misses() << " (" << std::fixed
+              << std::setprecision(2) << levels[i]->get_hit_rate() << "%)"
+              << std::endl;
+  }
+
+  std::cout << "  Page Walks: " << walks << " (" << walk_references
+            << " table references), TLB Shootdowns: " << shootdowns
+            << std::endl;
+  std::cout << "  Translation Cycles: " << cycles << " ("
+            << (lookups ? (double)cycles / lookups : 0.0) << " per access)"
+            << std::endl;
+}
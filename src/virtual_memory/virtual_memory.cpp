@@ -1,40 +1,190 @@
 #include "../../include/virtual_memory.h"
-#include <chrono>  
-#include <thread>
+#include <iomanip>
 
-void VirtualMemoryManager::init(size_t page_size, size_t virtual_size,
+void VirtualMemoryManager::init(size_t page_size, int address_bits,
                                 size_t physical_memory_size) {
   this->page_size = page_size;
-  size_t num_pages = virtual_size / page_size;
+  num_pages = (static_cast<size_t>(1) << address_bits) / page_size;
+  if (num_pages == 0)
+    num_pages = 1;
   this->total_frames = physical_memory_size / page_size;
-  page_table.clear();
-  page_table.resize(num_pages);
+  int page_number_bits = 0;
+  while ((num_pages - 1) >> page_number_bits)
+    page_number_bits++;
+  page_table.init(page_number_bits);
   frame_table.clear();
-  frame_table.assign(total_frames, -1);  
+  frame_table.assign(total_frames, NO_PAGE);
+  free_frames.clear();
+  for (size_t i = total_frames; i > 0; --i)
+    free_frames.push_back(i - 1);
+  lru_links.assign(total_frames, {NO_PAGE, NO_PAGE});
+  lru_head = lru_tail = NO_PAGE;
+  wsclock_cleanings = 0;
   fifo_pages.clear();
   page_faults = 0;
   page_hits = 0;
   access_counter = 0;
   clock_hand = 0;
+  sim_time = stall_time = 0;
+  writeback_pages.clear();
+  swap_ins = fresh_page_ins = swap_outs = swap_writes = swap_cache_hits = 0;
+  disk.reset();
+  tlb.reset();
+  reset_policy_state();
   std::cout << "VM Initialized: Page Size=" << page_size
             << ", Virtual Pages=" << num_pages
             << ", Physical Frames=" << total_frames << std::endl;
 }
 
+void VirtualMemoryManager::set_policy(ReplacementPolicy p, size_t window) {
+  policy = p;
+  wsclock_window = window;
+  reset_policy_state();
+}
+
+// Rebuilds the policy's own lists from the resident pages, oldest first by
+// recency, so switching policy mid-run starts from a consistent state.
+void VirtualMemoryManager::reset_policy_state() {
+  replacer = create_page_replacer(policy, total_frames);
+  fifo_pages.clear();
+
+  for (size_t frame = lru_tail; frame != NO_PAGE;
+       frame = lru_links[frame].prev) {
+    if (replacer)
+      replacer->on_fault(frame_table[frame]);
+    if (policy == ReplacementPolicy::FIFO)
+      fifo_pages.push_back(frame_table[frame]);
+  }
+}
+
 int VirtualMemoryManager::find_free_frame() {
+  if (free_frames.empty())
+    return -1;
+
+  size_t frame = free_frames.back();
+  free_frames.pop_back();
+  return frame;
+}
+
+void VirtualMemoryManager::lru_unlink(size_t frame) {
+  FrameLink &link = lru_links[frame];
+
+  if (link.prev != NO_PAGE)
+    lru_links[link.prev].next = link.next;
+  else
+    lru_head = link.next;
+
+  if (link.next != NO_PAGE)
+    lru_links[link.next].prev = link.prev;
+  else
+    lru_tail = link.prev;
+
+  link.prev = link.next = NO_PAGE;
+}
+
+void VirtualMemoryManager::lru_push_front(size_t frame) {
+  lru_links[frame] = {NO_PAGE, lru_head};
+
+  if (lru_head != NO_PAGE)
+    lru_links[lru_head].prev = frame;
+  else
+    lru_tail = frame;
+
+  lru_head = frame;
+}
+
+void VirtualMemoryManager::stall_until(uint64_t time) {
+  if (time <= sim_time)
+    return;
+  stall_time += time - sim_time;
+  sim_time = time;
+}
 
-  for (size_t i = 0; i < total_frames; ++i) {
+void VirtualMemoryManager::queue_write_back(size_t page_idx) {
+  for (size_t page : writeback_pages) {
+    if (page == page_idx)
+      return;
+  }
+
+  writeback_pages.push_back(page_idx);
+  if (writeback_pages.size() >= writeback_batch)
+    flush_write_backs();
+}
+
+// The buffered pages go out as one sequential write, so a batch costs a
+// single write latency on one disk channel.
+void VirtualMemoryManager::flush_write_backs() {
+  if (writeback_pages.empty())
+    return;
+
+  swap_outs += writeback_pages.size();
+  swap_writes++;
+  for (size_t page : writeback_pages)
+    page_table.get(page).swapped = true;
+
+  if (write_latency_ms > 0) {
+    disk.retire(sim_time);
+
+    if (disk.full()) {
+      stall_until(disk.next_completion());
+      disk.retire(sim_time);
+    }
+
+    disk.submit(sim_time, write_latency_ms * 1000ULL);
+  }
 
-    if (frame_table[i] == -1) {
-      return i;
+  std::cout << "  Swap-out: " << writeback_pages.size()
+            << " page(s) in one write" << std::endl;
+  writeback_pages.clear();
+}
+
+// Two sweeps: the first clears reference bits, so every page has been
+// judged on age alone by the end of the second. Old dirty pages are queued
+// for write-back and left in place, clean, for a later sweep to take. If
+// nothing is older than the window, the least recently used page goes,
+// clean ones first.
+size_t VirtualMemoryManager::wsclock_victim() {
+  size_t window = wsclock_window ? wsclock_window : total_frames;
+  size_t oldest_clean = NO_PAGE;
+  size_t oldest = NO_PAGE;
+
+  for (size_t n = 0; n < 2 * total_frames; ++n) {
+    size_t p_idx = frame_table[clock_hand];
+    clock_hand = (clock_hand + 1) % total_frames;
+
+    if (p_idx == NO_PAGE)
+      continue;
+
+    PageTableEntry &entry = page_table.get(p_idx);
+
+    if (entry.reference_bit) {
+      entry.reference_bit = false;
+      continue;
     }
+
+    size_t used = entry.last_access_time;
+    if (oldest == NO_PAGE || used < page_table.get(oldest).last_access_time)
+      oldest = p_idx;
+    if (!entry.dirty && (oldest_clean == NO_PAGE ||
+                         used < page_table.get(oldest_clean).last_access_time))
+      oldest_clean = p_idx;
+
+    if (access_counter - entry.last_access_time <= window)
+      continue;
+
+    if (!entry.dirty)
+      return p_idx;
+
+    entry.dirty = false;
+    wsclock_cleanings++;
+    queue_write_back(p_idx);
   }
 
-  return -1;  
+  return oldest_clean != NO_PAGE ? oldest_clean : oldest;
 }
 
-int VirtualMemoryManager::evict_page() {
-  size_t victim_page_idx = -1;
+int VirtualMemoryManager::evict_page(size_t incoming) {
+  size_t victim_page_idx = NO_PAGE;
 
   if (policy == ReplacementPolicy::FIFO) {
 
@@ -44,32 +194,20 @@ int VirtualMemoryManager::evict_page() {
     }
 
   } else if (policy == ReplacementPolicy::LRU) {
-    size_t min_time = static_cast<size_t>(-1);
-    int victim_frame = -1;
-
-    for (size_t i = 0; i < total_frames; ++i) {
-      int p_idx = frame_table[i];
-
-      if (p_idx != -1) {
-
-        if (page_table[p_idx].last_access_time < min_time) {
-          min_time = page_table[p_idx].last_access_time;
-          victim_page_idx = p_idx;
-          victim_frame = i;
-        }
-      }
-    }
+    if (lru_tail != NO_PAGE)
+      victim_page_idx = frame_table[lru_tail];
 
   } else if (policy == ReplacementPolicy::CLOCK) {
     int loops = 0;
 
     while (loops < 2) {
-      int p_idx = frame_table[clock_hand];
+      size_t p_idx = frame_table[clock_hand];
 
-      if (p_idx != -1) {
+      if (p_idx != NO_PAGE) {
+        PageTableEntry &entry = page_table.get(p_idx);
 
-        if (page_table[p_idx].reference_bit) {
-          page_table[p_idx].reference_bit = false;
+        if (entry.reference_bit) {
+          entry.reference_bit = false;
         } else {
           victim_page_idx = p_idx;
           break;
@@ -81,42 +219,102 @@ int VirtualMemoryManager::evict_page() {
         loops++;
     }
 
-    if (victim_page_idx != static_cast<size_t>(-1)) {
+    if (victim_page_idx != NO_PAGE) {
+      clock_hand = (clock_hand + 1) % total_frames;
+    }
+
+  } else if (policy == ReplacementPolicy::ENHANCED_CLOCK) {
+    // Odd sweeps look for unreferenced dirty pages and clear reference bits
+    // as they pass; even sweeps look for unreferenced clean ones. Four
+    // sweeps always find a victim, and clean pages go first.
+    for (int sweep = 0; sweep < 4 && victim_page_idx == NO_PAGE; ++sweep) {
+      bool want_dirty = sweep % 2 == 1;
+
+      for (size_t n = 0; n < total_frames; ++n) {
+        size_t p_idx = frame_table[clock_hand];
+
+        if (p_idx != NO_PAGE) {
+          PageTableEntry &entry = page_table.get(p_idx);
+
+          if (!entry.reference_bit && entry.dirty == want_dirty) {
+            victim_page_idx = p_idx;
+            break;
+          }
+
+          if (want_dirty)
+            entry.reference_bit = false;
+        }
+
+        clock_hand = (clock_hand + 1) % total_frames;
+      }
+    }
+
+    if (victim_page_idx != NO_PAGE) {
       clock_hand = (clock_hand + 1) % total_frames;
     }
+
+  } else if (policy == ReplacementPolicy::WSCLOCK) {
+    victim_page_idx = wsclock_victim();
+
+  } else if (replacer) {
+    victim_page_idx = replacer->victim(incoming);
   }
 
-  if (victim_page_idx != static_cast<size_t>(-1)) {
-    int frame = page_table[victim_page_idx].frame_number;
-    page_table[victim_page_idx].valid = false;
-    page_table[victim_page_idx].frame_number = -1;
-    frame_table[frame] = -1;
+  if (victim_page_idx != NO_PAGE) {
+    PageTableEntry &victim = page_table.get(victim_page_idx);
+    stall_until(victim.ready_time);
+    int frame = victim.frame_number;
+    bool dirty = victim.dirty;
+    victim.valid = false;
+    victim.dirty = false;
+    victim.frame_number = -1;
+    frame_table[frame] = NO_PAGE;
+    lru_unlink(frame);
+    tlb.invalidate(victim_page_idx);
     std::cout << "  Evicting Page " << victim_page_idx << " from Frame "
-              << frame << std::endl;
+              << frame << (dirty ? " (dirty)" : "") << std::endl;
+    if (dirty)
+      queue_write_back(victim_page_idx);
     return frame;
   }
 
   return -1;
 }
 
-bool VirtualMemoryManager::translate(size_t v_addr, size_t &p_addr) {
+bool VirtualMemoryManager::translate(size_t v_addr, size_t &p_addr,
+                                     bool is_write) {
   if (page_size == 0)
     return false;
   access_counter++;
   size_t page_idx = v_addr / page_size;
   size_t offset = v_addr % page_size;
 
-  if (page_idx >= page_table.size()) {
+  if (page_idx >= num_pages) {
     std::cout << "SegFault: Virtual Address " << v_addr << " out of bounds."
               << std::endl;
     return false;
   }
 
-  if (page_table[page_idx].valid) {
+  sim_time += cpu_time_us;
+  int depth = 0;
+  PageTableEntry *pte = page_table.find(page_idx, &depth);
+
+  if (!tlb.lookup(page_idx))
+    tlb.record_walk(depth);
+
+  if (pte && pte->valid) {
     page_hits++;
-    page_table[page_idx].last_access_time = access_counter;
-    page_table[page_idx].reference_bit = true;
-    int frame = page_table[page_idx].frame_number;
+    pte->last_access_time = access_counter;
+    pte->reference_bit = true;
+    pte->dirty |= is_write;
+    if (replacer)
+      replacer->on_hit(page_idx);
+    stall_until(pte->ready_time);
+    int frame = pte->frame_number;
+    if (lru_head != static_cast<size_t>(frame)) {
+      lru_unlink(frame);
+      lru_push_front(frame);
+    }
     p_addr = (frame * page_size) + offset;
     return true;
   }
@@ -125,16 +323,10 @@ bool VirtualMemoryManager::translate(size_t v_addr, size_t &p_addr) {
   std::cout << "  Page Fault at address " << v_addr << " (Page " << page_idx
             << ")" << std::endl;
 
-  if (disk_latency_ms > 0) {
-    std::cout << "  (Simulating Disk I/O: " << disk_latency_ms << "ms)..."
-              << std::endl;
-    std::this_thread::sleep_for(std::chrono::milliseconds(disk_latency_ms));
-  }
-
   int frame = find_free_frame();
 
   if (frame == -1) {
-    frame = evict_page();
+    frame = evict_page(page_idx);
   }
 
   if (frame == -1) {
@@ -144,11 +336,50 @@ bool VirtualMemoryManager::translate(size_t v_addr, size_t &p_addr) {
     return false;
   }
 
-  page_table[page_idx].valid = true;
-  page_table[page_idx].frame_number = frame;
-  page_table[page_idx].last_access_time = access_counter;
-  page_table[page_idx].reference_bit = true;
+  uint64_t ready = sim_time;
+  bool buffered = false;
+
+  for (size_t i = 0; i < writeback_pages.size(); ++i) {
+    if (writeback_pages[i] == page_idx) {
+      writeback_pages.erase(writeback_pages.begin() + i);
+      buffered = true;
+      break;
+    }
+  }
+
+  if (buffered) {
+    swap_cache_hits++;
+    std::cout << "  (Page reclaimed from write-back buffer)" << std::endl;
+  } else if (disk_latency_ms > 0) {
+    disk.retire(sim_time);
+
+    if (disk.full()) {
+      stall_until(disk.next_completion());
+      disk.retire(sim_time);
+    }
+
+    ready = disk.submit(sim_time, disk_latency_ms * 1000ULL);
+    std::cout << "  (Page-in queued: " << disk_latency_ms
+              << "ms disk read, ready at " << ready / 1000.0 << "ms)"
+              << std::endl;
+  }
+
+  pte = &page_table.get(page_idx);
+  if (!buffered && pte->swapped)
+    swap_ins++;
+  else if (!buffered)
+    fresh_page_ins++;
+
+  pte->ready_time = ready;
+  pte->valid = true;
+  pte->dirty = buffered || is_write;
+  pte->frame_number = frame;
+  pte->last_access_time = access_counter;
+  pte->reference_bit = true;
   frame_table[frame] = page_idx;
+  lru_push_front(frame);
+  if (replacer)
+    replacer->on_fault(page_idx);
 
   if (policy == ReplacementPolicy::FIFO) {
     fifo_pages.push_back(page_idx);
@@ -166,11 +397,41 @@ void VirtualMemoryManager::print_stats() {
                     ? (double)page_hits / (page_hits + page_faults) * 100.0
                     : 0.0;
   std::cout << "  Hit Rate:    " << rate << "%" << std::endl;
+  tlb.print_stats();
+  page_table.print_stats();
+
+  if (replacer)
+    replacer->print_stats();
+  if (policy == ReplacementPolicy::WSCLOCK)
+    std::cout << "  WSClock: window "
+              << (wsclock_window ? wsclock_window : total_frames)
+              << " accesses, " << wsclock_cleanings << " pages cleaned"
+              << std::endl;
 
   if (disk_latency_ms > 0) {
     std::cout << "  Disk Latency per Fault: " << disk_latency_ms << "ms"
               << std::endl;
   }
 
+  if (disk_latency_ms > 0 || write_latency_ms > 0)
+    disk.print_stats();
+
+  std::cout << "  Swap In:  " << swap_ins << " pages ("
+            << swap_ins * page_size << " bytes), " << fresh_page_ins
+            << " page-ins with no swap copy" << std::endl;
+  std::cout << "  Swap Out: " << swap_outs << " pages ("
+            << swap_outs * page_size << " bytes) in " << swap_writes
+            << " writes of up to " << writeback_batch << ", "
+            << writeback_pages.size() << " buffered, " << swap_cache_hits
+            << " reclaimed" << std::endl;
+
+  uint64_t elapsed =
+      disk.drained_at() > sim_time ? disk.drained_at() : sim_time;
+  std::cout << "  Simulated Time: " << std::fixed << std::setprecision(2)
+            << elapsed / 1000.0 << "ms (stalled " << stall_time / 1000.0
+            << "ms), Throughput: "
+            << (elapsed ? access_counter * 1e6 / elapsed : 0.0)
+            << " accesses/s" << std::endl;
+
   std::cout << "=================================\n" << std::endl;
 }
\ No newline at end of file